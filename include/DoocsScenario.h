@@ -0,0 +1,93 @@
+#pragma once
+
+#include "doocsServerTestHelper.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ *  Scenario for data-driven tests: a compact script of property writes, update cycles and expected values, which is
+ *  executed through the DoocsServerTestHelper. The property addresses are resolved once on the first run, so the
+ *  execution only pays for the property accesses themselves.
+ *
+ *  Script syntax (one command per line, "#" starts a comment, values containing spaces can be quoted with ""):
+ *
+ *    set <property> <value>                       write the value to the property
+ *    step [<n>]                                   run n update cycles (default 1), see runUpdate()
+ *    sigusr1 [<n>]                                run n sigusr1 cycles (default 1), see runSigusr1()
+ *    expect <property> <value> [+- <tolerance>]   compare the value of the property
+ *    waitfor <property> <value> [+- <tolerance>] [within <n>]
+ *                                                 run update cycles one by one until the property has the value, at
+ *                                                 most n cycles (default 1000)
+ *
+ *  Properties are given in the form "//<location>/<property>". Integer values are written and compared as 64-bit
+ *  integers, so they are exact over the full range of 64-bit properties. Other numeric values are written and compared
+ *  as double. Numeric values are compared with the given tolerance (default 0), other values are compared as strings.
+ *  Only scalar properties are supported.
+ */
+class DoocsScenario {
+ public:
+  /** parse the script from a file. Throws std::runtime_error on syntax errors. */
+  static DoocsScenario fromFile(const std::string& fileName);
+
+  /** parse the script from a string. Throws std::runtime_error on syntax errors. */
+  static DoocsScenario fromString(const std::string& script, const std::string& sourceName = "<string>");
+
+  /** a failed expect or waitfor command */
+  struct Failure {
+    std::string source;
+    size_t line;
+    std::string message;
+  };
+
+  /** execute the scenario and return the failures. Stops at the first failure unless continueOnFailure is set. */
+  std::vector<Failure> run(bool continueOnFailure = false);
+
+  /** number of commands in the scenario */
+  size_t size() const { return _commands.size(); }
+
+ protected:
+  DoocsScenario() = default;
+
+  enum class CommandType { set, step, sigusr1, expect, waitFor };
+
+  struct Command {
+    CommandType type;
+    size_t line;
+    std::string property;
+
+    /** value as written in the script, and converted if it is numeric */
+    std::string value;
+    std::optional<double> numericValue;
+    std::optional<int64_t> integerValue;
+    double tolerance{0};
+
+    /** number of cycles for step and sigusr1, maximum number of cycles for waitfor */
+    size_t count{1};
+
+    /** property handles, resolved on the first run */
+    bool resolved{false};
+    std::optional<DoocsServerTestHelper::PropertyHandle<int64_t>> integerHandle;
+    std::optional<DoocsServerTestHelper::PropertyHandle<double>> doubleHandle;
+    std::optional<DoocsServerTestHelper::PropertyHandle<std::string>> stringHandle;
+  };
+
+  /** parse a single line and append the command, if any */
+  void parseLine(const std::string& line, size_t lineNumber);
+
+  /** resolve the property handles needed by the command */
+  static void resolve(Command& command);
+
+  /** compare the current value of the property with the expected value. Returns an error message on mismatch. */
+  static std::optional<std::string> compare(Command& command);
+
+  /** compare the given value with the expected value of the command. Returns an error message on mismatch. */
+  static std::optional<std::string> compare(const Command& command, double actual);
+  static std::optional<std::string> compare(const Command& command, int64_t actual);
+  static std::optional<std::string> compare(const Command& command, const std::string& actual);
+
+  std::string _source;
+  std::vector<Command> _commands;
+};
@@ -9,39 +9,122 @@
 
 #include <eq_fct.h>
 
+#include <fstream>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
 #include <thread>
+#include <vector>
 
 class ThreadedDoocsServer {
  public:
+  /**
+   *  Values to be replaced in the config file, indexed by the config key (e.g. "SVR.TIMEOUT"). Each line of the config
+   *  file starting with "<key>:" is replaced by "<key>: <value>". Keys which are not present in the config file are
+   *  ignored. SVR.RPC_NUMBER and SVR.BPN are always replaced with the values of rpcNo() and bpn().
+   */
+  using ConfigOverrides = std::map<std::string, std::string, std::less<>>;
+
   ThreadedDoocsServer(std::string configFile, int argc, char* argv[], std::unique_ptr<doocs::Server> doocsServer,
-      bool autoStart = true);
+      bool autoStart = true, ConfigOverrides configOverrides = {});
 
   void start();
 
+  /**
+   *  Reset the server between test cases, so a single server instance can be shared by a whole test suite:
+   *  - the state of the DoocsServerTestHelper is reset, see DoocsServerTestHelper::reset(),
+   *  - all properties are set back to the state saved with saveState(). If no state has been saved, all properties
+   *    which have a value in the config file are set back to that value (after applying the config overrides).
+   *  Properties not present in the saved state resp. the config file or not writeable (e.g. read-only properties) keep
+   *  their current values. The server location and SVR.* keys are not touched. The history is not reset, since DOOCS
+   *  keeps the history files open while running.
+   */
+  void reset();
+
+  /**
+   *  Save the current values of all properties as the clean state restored by reset(). Call this once after the
+   *  server has been brought up to the state each test case should start from (e.g. after start() and the setup
+   *  cycles). Compared to the config values, this also covers properties initialised by the server code itself.
+   */
+  void saveState();
+
+  /**
+   *  Stop the server. DOOCS can only be stopped as a whole with eq_exit(), so if other ThreadedDoocsServer objects of
+   *  the process are still running, the server threads of this instance are kept blocked (see
+   *  DoocsServerTestHelper::Instance::retire()), so they do not interfere with the remaining servers. Its DOOCS threads
+   *  are released and joined when the last server is destroyed, which calls DoocsServerTestHelper::shutdown().
+   */
   virtual ~ThreadedDoocsServer();
 
+  /** RPC number of this instance. The number is claimed on first use by locking a lock file in the lock directory, so
+   *  concurrently running servers (in this or other processes) never use the same number. */
   std::string rpcNo();
 
+  /** BPN of this instance, claimed like the RPC number */
   std::string bpn();
 
+  /** Set the directory for the lock files used to claim RPC numbers and BPNs. All concurrently running tests must use
+   *  the same directory. By default, the directory is taken from the environment variable
+   *  DOOCS_SERVER_TEST_LOCK_DIR. If that is not set, /var/lock is used if writeable, otherwise the temp directory. */
+  static void setLockDirectory(const std::string& directory);
+
+  static std::string getLockDirectory();
+
+  /** Names of all locations in the config file, e.g. to take a snapshot of the whole server with
+   *  DoocsServerTestHelper::takeSnapshot() */
+  std::vector<std::string> getLocationNames() const;
+
  protected:
+  /** Exclusive lock on a lock file. The file is created when locking and removed when the lock is released. */
+  class LockFile {
+   public:
+    LockFile() = default;
+    LockFile(const LockFile&) = delete;
+    LockFile& operator=(const LockFile&) = delete;
+    ~LockFile() { release(); }
+
+    /** try to create and lock the file, returns false if it is already locked by someone else (without blocking) */
+    bool tryLock(const std::string& path);
+
+    void release();
+
+   protected:
+    int _fd{-1};
+    std::string _path;
+  };
+
+  /** Claim a number by locking the lock file "<prefix><number>.lock" in the lock directory. Random candidates are
+   *  drawn from the distribution until a lock succeeds. The result is multiplied by the given factor. */
+  static std::string claimNumber(
+      const std::string& prefix, std::uniform_int_distribution<int> distribution, int factor, LockFile& lock);
+
+  /** Write the config file of this instance by copying the original config file and applying the overrides */
+  void writeConfigInstance();
+
+  /** Write the values from the original config file back into the properties of the running server */
+  void restoreConfigValues();
+
+  /** Write the values saved by saveState() back into the properties of the running server */
+  void restoreSavedState();
+
   std::mutex _mx_serverInfo;
   std::shared_ptr<char[]> _serverNameInstanceC;
   std::vector<char*> _argv{};
   std::string _serverName{}, _serverNameInstance{};
   std::string _rpcNo{}, _bpn{};
   std::string _configFile{}, _configFileInstance{};
-  std::string _rpcNoLockFile{};
-  std::string _bpnLockFile{};
+  ConfigOverrides _configOverrides;
+  std::string _histDir{};
+
+  /** properties and values saved by saveState(). Values which could not be read are nullptr. */
+  std::shared_ptr<const DoocsServerTestHelper::Snapshot::Layout> _savedLayout;
+  std::vector<std::unique_ptr<EqData>> _savedValues;
+
   boost::interprocess::file_lock _configMutex;
-  boost::interprocess::file_lock _rpcNoMutex;
-  boost::interprocess::file_lock _bpnMutex;
   std::unique_lock<boost::interprocess::file_lock> _configLock;
-  std::unique_lock<boost::interprocess::file_lock> _rpcNoLock;
-  std::unique_lock<boost::interprocess::file_lock> _bpnLock;
+  LockFile _rpcNoLock;
+  LockFile _bpnLock;
   std::thread _doocsServerThread;
   std::unique_ptr<doocs::Server> _doocsServer;
 };
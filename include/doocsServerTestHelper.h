@@ -15,15 +15,28 @@
 #include <eq_fct.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
 #include <type_traits>
 
 class HelperTest;
+class ThreadedDoocsServer;
 
 /** Handy assertion macro */
 #define ASSERT(condition, error_message)                                                                               \
@@ -32,6 +45,52 @@ class HelperTest;
     assert(false);                                                                                                     \
   }
 
+namespace detail {
+  template<typename TYPE>
+  struct IsVector : std::false_type {};
+
+  template<typename TYPE>
+  struct IsVector<std::vector<TYPE>> : std::true_type {};
+
+  template<typename TYPE>
+  constexpr bool alwaysFalse = false;
+
+  /** DOOCS data type used to write arrays with the element type TYPE. Unsigned types are mapped to the next larger
+   *  signed type and signed 8 bit types to shorts (DOOCS bytes are unsigned), so no values are lost. Unsupported types
+   *  (e.g. unsigned 64 bit integers) fail to compile. */
+  template<typename TYPE>
+  constexpr int doocsArrayType() {
+    if constexpr(std::is_same<TYPE, bool>()) {
+      return DATA_A_BOOL;
+    }
+    else if constexpr(std::is_integral<TYPE>() && std::is_unsigned<TYPE>() && sizeof(TYPE) == 1) {
+      return DATA_A_BYTE;
+    }
+    else if constexpr(std::is_same<TYPE, short>() || (std::is_integral<TYPE>() && sizeof(TYPE) == 1)) {
+      return DATA_A_SHORT;
+    }
+    else if constexpr(std::is_same<TYPE, int>() || std::is_same<TYPE, unsigned short>()) {
+      return DATA_A_INT;
+    }
+    else if constexpr(std::is_same<TYPE, unsigned int>() ||
+        (std::is_integral<TYPE>() && std::is_signed<TYPE>() && sizeof(TYPE) == sizeof(int64_t))) {
+      return DATA_A_LONG;
+    }
+    else if constexpr(std::is_same<TYPE, float>()) {
+      return DATA_A_FLOAT;
+    }
+    else if constexpr(std::is_same<TYPE, double>()) {
+      return DATA_A_DOUBLE;
+    }
+    else {
+      static_assert(alwaysFalse<TYPE>, "Unsupported data type for DOOCS array properties.");
+      return DATA_NULL;
+    }
+  }
+} // namespace detail
+
+/**********************************************************************************************************************/
+
 /** Collection of helper routines to test DOOCS servers: control the DOOCS
  * update() and interrupt_usr1() functions and access properties directly
  * through pointers (instead of the RPC interface). The class has only static
@@ -49,9 +108,36 @@ class HelperTest;
 
 class DoocsServerTestHelper {
  public:
+  /** Policy for retrying property accesses which report an error, e.g. because the property is temporarily busy. After
+   *  a failed attempt, the access is retried after initialDelay. The delay is multiplied by backoffFactor after each
+   *  further attempt, but will not exceed maxDelay. Retrying stops once the next attempt would start after the
+   *  deadline (measured from the first attempt). If failFast is set, no retries are done at all. Delays shorter than
+   *  minimumDelay (including an initialDelay of 0) are raised to minimumDelay, so retrying never spins.
+   *
+   *  The default policy retries every 10ms for up to 10s.
+   */
+  struct RetryPolicy {
+    static constexpr std::chrono::microseconds minimumDelay{100};
+
+    std::chrono::microseconds initialDelay{10000};
+    double backoffFactor{1.};
+    std::chrono::microseconds maxDelay{10000};
+    std::chrono::microseconds deadline{10000000};
+    bool failFast{false};
+
+    bool operator==(const RetryPolicy&) const = default;
+  };
+
+  /** Set the retry policy used by all property accessors which are not given a policy explicitly */
+  static void setRetryPolicy(const RetryPolicy& retryPolicy);
+
+  /** Get the retry policy used by all property accessors which are not given a policy explicitly */
+  static RetryPolicy getRetryPolicy();
+
   /** If doNotProcessSignalsInDoocs is set to true, DOOCS will not receive any
    * signals via sigwait() to process. This allows catching signals via signal
-   * handlers (e.g. sigaction).
+   * handlers (e.g. sigaction). A signal thread blocked this way is released by
+   * shutdown() and then receives SIGUSR1 instead of the suppressed signal.
    */
   static void setDoNotProcessSignalsInDoocs(bool doNotProcessSignalsInDoocs = true);
 
@@ -73,46 +159,357 @@ class DoocsServerTestHelper {
    * processing is finished */
   static void runUpdate();
 
-  /** shutdown the doocs server */
-  static void shutdown();
+  /** Callback type for the batched versions of runSigusr1() and runUpdate(). The argument is the index of the
+   *  completed cycle within the batch, starting at 0. */
+  using CycleCallback = std::function<void(size_t cycle)>;
+
+  /** trigger doocs to run interrupt_usr1() nCycles times in a row and wait until the processing is finished. The
+   *  cycles are executed back to back without waking up the test thread in between. If given, onCycleCompleted is
+   *  called after each completed cycle. It is executed in the DOOCS signal thread before the next cycle starts, so it
+   *  may e.g. set properties for the next cycle, but it must not call runSigusr1() or runUpdate(). */
+  static void runSigusr1(size_t nCycles, const CycleCallback& onCycleCompleted = {});
+
+  /** trigger doocs to run update() nCycles times in a row and wait until the processing is finished. The cycles are
+   *  executed back to back without waking up the test thread in between. If given, onCycleCompleted is called after
+   *  each completed cycle. It is executed in the DOOCS update thread before the next cycle starts, so it may e.g. set
+   *  properties for the next cycle, but it must not call runSigusr1() or runUpdate(). */
+  static void runUpdate(size_t nCycles, const CycleCallback& onCycleCompleted = {});
+
+  /** trigger doocs to run interrupt_usr1() nCycles times without waiting for the processing to finish. The returned
+   *  future becomes ready once the last cycle is complete (or the server is shut down). Meanwhile, the test thread may
+   *  e.g. set properties for the next step or verify results of the previous step. Only one batch can be processed at
+   *  a time, so a subsequent call to runSigusr1() or runSigusr1Async() first waits until this batch is complete. */
+  static std::future<void> runSigusr1Async(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  /** deliver the given signal to the DOOCS signal thread and wait until it has been handled, i.e. until the thread
+   *  has re-entered sigwait(). This works like runSigusr1() for any signal of the set the thread waits for, e.g.
+   *  SIGUSR2 or SIGTERM. The set is only known once the thread has entered sigwait() with SIGUSR1 in the set, which is
+   *  awaited for at most the given timeout. Throws std::logic_error if the signal is not in that set or if no such
+   *  thread shows up in time. */
+  static void runSignal(int sig, std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+  /** trigger doocs to run update() nCycles times without waiting for the processing to finish. The returned future
+   *  becomes ready once the last cycle is complete (or the server is shut down). Meanwhile, the test thread may e.g.
+   *  set properties for the next step or verify results of the previous step. Only one batch can be processed at a
+   *  time, so a subsequent call to runUpdate() or runUpdateAsync() first waits until this batch is complete. */
+  static std::future<void> runUpdateAsync(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  /** run update() nCycles times only for the given locations and wait until the processing is finished. The DOOCS
+   *  update thread is not triggered, so all other locations stay frozen. update() is called directly from the calling
+   *  thread with the location locked, like the DOOCS update thread does (but without refresh_prolog() and
+   *  refresh_epilog()). Each cycle is treated like a cycle of the update thread: it advances the virtual clock by
+   *  advancePerUpdate, update() sees the virtual time, the processing time is recorded in the update statistics and
+   *  the progress is signalled (see getEventFd()). An update batch of the default instance which is still running is
+   *  completed first, and no new batch can be started until this function returns. Throws std::logic_error if the
+   *  default instance is free-running. */
+  static void runUpdateFor(const std::vector<EqFct*>& locations, size_t nCycles = 1);
+
+  /** same as above, with the locations given by name (the <location> part of "//<location>/<property>") */
+  static void runUpdateFor(const std::vector<std::string>& locationNames, size_t nCycles = 1);
+
+  /** Switch the update thread into free-running mode, e.g. for soak tests or to measure the maximum update rate of the
+   *  server: waitForUpdate() returns immediately, so update() runs back to back. If period is non-zero, the cycles are
+   *  paced to start at most once per period instead. A running update batch is completed first. While free-running,
+   *  runUpdate() blocks until stopFreeRunning() is called. */
+  static void startFreeRunning(std::chrono::nanoseconds period = std::chrono::nanoseconds(0));
+
+  /** Return to lock-step mode. Waits until the update thread is blocked in waitForUpdate() again, so the server state
+   *  can be inspected afterwards. */
+  static void stopFreeRunning();
+
+  /** Cycle counters of the free-running mode */
+  struct FreeRunningStatistics {
+    /** number of update cycles since the last call to startFreeRunning() */
+    uint64_t cycles{0};
+
+    /** time since the last call to startFreeRunning(), until stopFreeRunning() if already stopped */
+    std::chrono::nanoseconds duration{0};
+
+    double cyclesPerSecond() const {
+      return duration.count() > 0 ? double(cycles) * 1e9 / double(duration.count()) : 0.;
+    }
+  };
+
+  static FreeRunningStatistics getFreeRunningStatistics();
+
+  /** File descriptor which becomes readable when the server makes progress: an update or sigusr1 cycle completes
+   *  (of any instance, including free-running and runUpdateFor() cycles), a batch started with runUpdateAsync() resp.
+   *  runSigusr1Async() completes or the server threads have been released by shutdown() resp. Instance::release().
+   *  This allows integrating the handshake into event loops (poll, epoll etc.) together with other file descriptors.
+   *  The completion of an asynchronous batch is a separate event, signalled after its future has become ready, so the
+   *  future can be checked without blocking whenever the descriptor is readable.
+   *
+   *  The descriptor is an eventfd created on the first call. Reading 8 bytes returns the number of events since the
+   *  last read and makes it non-readable again. It is owned by the helper and must not be closed. */
+  static int getEventFd();
+
+  class Subscription;
+
+  /** Subscribe to the events observed by the helper: completed update and sigusr1 cycles (of all instances, including
+   *  free-running and runUpdateFor() cycles) and property writes through the helper. Changes made by the server on
+   *  its own (e.g. in other threads or through RPC calls) are not observed. */
+  static Subscription subscribe();
+
+  /** Wait until the value of the property fulfils the predicate, which is called with the value of type TYPE. The
+   *  property is read again right after each event observed by the helper (see subscribe()), so the function returns
+   *  as soon as the condition becomes true. Since changes made by the server on its own (e.g. from application
+   *  threads) are not observed, the property is also read again at least every pollInterval. Returns false if the
+   *  condition is not fulfilled within the timeout. Reads are retried according to the current retry policy (see
+   *  setRetryPolicy()), but never beyond the timeout.
+   *  "name" is the property name in the form "//<location>/<property>"
+   */
+  template<typename TYPE, typename PREDICATE>
+  static bool waitForValue(const std::string& name, PREDICATE predicate, std::chrono::milliseconds timeout,
+      std::chrono::milliseconds pollInterval = std::chrono::milliseconds(5));
+
+  class Snapshot;
+
+  /** Capture the values of all properties of the given locations (the <location> part of "//<location>/<property>").
+   *  The properties of each location are read in one pass while holding the location lock. Use Snapshot::diff() to
+   *  find out which properties have changed between two snapshots. */
+  static Snapshot takeSnapshot(const std::vector<std::string>& locationNames);
+
+  /** Capture the same properties again as in the given snapshot. The property list and addresses are reused, so this
+   *  is cheap enough to be done after every cycle. */
+  static Snapshot takeSnapshot(const Snapshot& previous);
+
+  /** shutdown the doocs server: calls eq_exit() and releases the server threads waiting for the next update or
+   *  sigusr1 cycle. Returns as soon as all waiting server threads have left the wait functions, or after the given
+   *  timeout. */
+  static void shutdown(std::chrono::milliseconds timeout = std::chrono::seconds(1));
+
+  /** reset the state of the DoocsServerTestHelper between test cases sharing the same server: stop free-running mode
+   *  and wait until pending update and sigusr1 batches of all instances are complete, then reset the timing
+   *  statistics, the default retry policy and the doNotProcessSignalsInDoocs flag, and disable the virtual clock. Has
+   *  no effect on a server which has already been shut down. */
+  static void reset();
+
+  /** Handshake state of one doocs::Server, see getInstance() */
+  class Instance;
+
+  /** Obtain the handshake state of the given server, which must have been passed to initialise() before. This allows
+   *  to drive several servers in one process independently. The static functions runUpdate(), runSigusr1() etc. act on
+   *  the default instance, which belongs to the first server passed to initialise() (or to the HelperTest). Passing
+   *  nullptr returns the default instance.
+   *  Note that only the handshakes are kept per server. DOOCS itself keeps the server state process-global (e.g. the
+   *  list of locations, the server location and eq_exit(), which stops all servers of the process), so several
+   *  servers in one process share their locations and can only be shut down together. */
+  static Instance& getInstance(const doocs::Server* server);
+
+  /** Histogram of durations with logarithmic buckets (4 buckets per power of two, i.e. a resolution of better than
+   *  25%). Recording is lock-free, so it can be done from the server threads while other threads read the histogram.
+   */
+  class LatencyHistogram {
+   public:
+    /** add a duration to the histogram */
+    void record(std::chrono::nanoseconds duration);
+
+    /** number of recorded durations */
+    uint64_t count() const;
+
+    /** duration below which the fraction p (0..1) of the recorded durations lie, rounded up to the bucket boundary.
+     *  Returns 0 if nothing has been recorded. */
+    std::chrono::nanoseconds percentile(double p) const;
+
+    /** remove all recorded durations */
+    void reset();
+
+   protected:
+    static constexpr size_t nBuckets = 252;
+    static size_t bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint64_t>, nBuckets> _buckets{};
+  };
+
+  /** Timing statistics for the update or interrupt_usr1 cycles */
+  struct CycleStatistics {
+    /** time from triggering the cycle until the server thread starts processing it */
+    LatencyHistogram wakeup;
+
+    /** time the server thread spends processing the cycle, until it re-enters waitForUpdate() resp. sigwait() */
+    LatencyHistogram processing;
+
+    /** time from the server re-entering the wait function until runUpdate() resp. runSigusr1() returns. Only recorded
+     *  for the synchronous functions. */
+    LatencyHistogram completion;
+  };
+
+  /** timing statistics of the update() cycles */
+  static const CycleStatistics& getUpdateStatistics();
+
+  /** timing statistics of the interrupt_usr1() cycles */
+  static const CycleStatistics& getSigusr1Statistics();
+
+  /** reset all timing statistics */
+  static void resetStatistics();
+
+  /** print a percentile summary of the timing statistics */
+  static void printStatistics(std::ostream& stream = std::cout);
+
+  /** if enabled, printStatistics() is called in shutdown() */
+  static void setPrintStatisticsOnShutdown(bool enable = true);
+
+  /** Enable the virtual clock, so time-dependent server logic can run faster than real time. While enabled, the wall
+   *  clock (CLOCK_REALTIME as read through clock_gettime(), gettimeofday(), time() and std::chrono::system_clock)
+   *  returns the virtual time in the server threads driven by the helper (i.e. threads which have waited for an update
+   *  or sigusr1 cycle, and update() called through runUpdateFor()), starting at the given time. All other threads
+   *  (e.g. the test thread, RPC or ZeroMQ threads) keep seeing the real time, so their absolute deadlines stay
+   *  consistent with the real clock. Use getVirtualClockTime() to read the virtual time from there. The virtual time
+   *  only advances through advanceVirtualClock() and, if advancePerUpdate is non-zero, by that amount at the start of
+   *  each update cycle. Sleeps (nanosleep(), clock_nanosleep(), usleep(), sleep() and std::this_thread::sleep_for())
+   *  in the server threads wait until the virtual time has been advanced past their wakeup time. Sleeps in other
+   *  threads are not affected. Note that a sleep inside update() is not completed by advancePerUpdate, since that is
+   *  applied at the start of the next cycle. Timed waits which take a CLOCK_REALTIME deadline without going through
+   *  the functions above (pthread_cond_timedwait(), sem_timedwait(), std::condition_variable::wait_until() with the
+   *  system clock) are not intercepted: in the server threads, such deadlines computed from the virtual time are
+   *  interpreted in real time. Monotonic clocks always return the real time, since they are used for condition
+   *  variables and timeouts. */
+  static void enableVirtualClock(std::chrono::nanoseconds advancePerUpdate = std::chrono::nanoseconds(0),
+      std::chrono::system_clock::time_point start = std::chrono::system_clock::now());
+
+  /** disable the virtual clock, the wall clock jumps back to real time and sleeping server threads are woken up */
+  static void disableVirtualClock();
+
+  /** advance the virtual clock and wake up server threads whose sleeps have expired */
+  static void advanceVirtualClock(std::chrono::nanoseconds duration);
+
+  static bool getVirtualClockEnabled();
+
+  /** current time of the virtual clock, as seen by the server threads. Only meaningful while the clock is enabled. */
+  static std::chrono::system_clock::time_point getVirtualClockTime();
+
+  /** Replacements for the clock and sleep functions, see enableVirtualClock(). Public to be able to unit-test them. */
+  static int clock_gettime(clockid_t clockId, struct timespec* tp);
+  static int clock_nanosleep(clockid_t clockId, int flags, const struct timespec* request, struct timespec* remaining);
 
   /** set a DOOCS property
    *  "name" is the property name in the form "//<location>/<property>"
    *  "value" is the value to be set
+   *  "retryPolicy" determines how long to retry if the property reports an error
    */
   template<typename TYPE>
-  static void doocsSet(const std::string& name, TYPE value);
+  static void doocsSet(const std::string& name, TYPE value, const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** set a DOOCS property - array version
    *  "name" is the property name in the form "//<location>/<property>"
    *  "value" is the value to be set
+   *  "retryPolicy" determines how long to retry if the property reports an error
    */
   template<typename TYPE>
-  static void doocsSet(const std::string& name, const std::vector<TYPE>& value);
+  static void doocsSet(
+      const std::string& name, const std::vector<TYPE>& value, const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** set a DOOCS property - spectrum version
    *  "name" is the property name in the form "//<location>/<property>"
    *  "value" is the value to be set
+   *  "retryPolicy" determines how long to retry if the property reports an error
+   *
+   *  The data is passed to DOOCS without intermediate copy by the helper. DOOCS copies it once into the EqData, so the
+   *  peak additional memory during the call is the size of the data.
+   */
+  static void doocsSetSpectrum(
+      const std::string& name, std::span<const float> value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** same as above, for source compatibility with calls passing a braced initialiser list */
+  static void doocsSetSpectrum(
+      const std::string& name, const std::vector<float>& value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** set a DOOCS property - spectrum version for double precision input
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "value" is the value to be set
+   *  "retryPolicy" determines how long to retry if the property reports an error
+   *
+   *  DOOCS spectra store single precision values, so each value is rounded to float: precision beyond about 7
+   *  significant digits is lost, and values outside the float range become infinite. The data is converted into a
+   *  temporary buffer, which is freed before returning. The peak additional memory during the call is twice the size
+   *  of the converted data (conversion buffer plus the copy inside the EqData).
    */
-  static void doocsSetSpectrum(const std::string& name, const std::vector<float>& value);
+  static void doocsSetSpectrum(
+      const std::string& name, std::span<const double> value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** set a DOOCS property - image version
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "header" is the image header describing the data (width, height, bytes per pixel, format etc.)
+   *  "value" is the image data
+   *  "retryPolicy" determines how long to retry if the property reports an error
+   *
+   *  The data is passed to DOOCS without intermediate copy by the helper. DOOCS copies it once into the EqData, so the
+   *  peak additional memory during the call is the size of the data.
+   */
+  static void doocsSetImage(const std::string& name, const IMH& header, std::span<const uint8_t> value,
+      const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** set a DOOCS property - IIII version
    *  "name" is the property name in the form "//<location>/<property>"
    *  "value" is the value to be set
+   *  "retryPolicy" determines how long to retry if the property reports an error
    */
-  static void doocsSetIIII(const std::string& name, const std::vector<int>& value);
+  static void doocsSetIIII(
+      const std::string& name, const std::vector<int>& value, const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** get a scalar DOOCS property
    *  "name" is the property name in the form "//<location>/<property>"
+   *  "retryPolicy" determines how long to retry if the property reports an error
    */
   template<typename TYPE>
-  static TYPE doocsGet(const std::string& name);
+  static TYPE doocsGet(const std::string& name, const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** get an array DOOCS property
    *  "name" is the property name in the form "//<location>/<property>"
+   *  "retryPolicy" determines how long to retry if the property reports an error
    */
   template<typename TYPE>
-  static std::vector<TYPE> doocsGetArray(const std::string& name);
+  static std::vector<TYPE> doocsGetArray(const std::string& name, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** get an array DOOCS property into an existing vector, which is resized to the length of the property. The memory
+   *  of the vector is reused if its capacity is sufficient.
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "value" is the vector to be filled
+   *  "retryPolicy" determines how long to retry if the property reports an error
+   */
+  template<typename TYPE>
+  static void doocsGetArray(
+      const std::string& name, std::vector<TYPE>& value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** get an array DOOCS property into a caller-provided buffer. Returns the number of elements of the property. If
+   *  the buffer is too small, only value.size() elements are written, so a return value larger than value.size()
+   *  indicates a truncation.
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "value" is the buffer to be filled
+   *  "retryPolicy" determines how long to retry if the property reports an error
+   */
+  template<typename TYPE>
+  static size_t doocsGetArray(
+      const std::string& name, std::span<TYPE> value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  template<typename TYPE>
+  class PropertyHandle;
+
+  /** obtain a handle to a DOOCS property, which allows repeated access without parsing the address and looking up
+   *  the location each time
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  TYPE is the user type, either a scalar type, std::string or a std::vector of a scalar type for array properties
+   */
+  template<typename TYPE>
+  static PropertyHandle<TYPE> getPropertyHandle(const std::string& name);
+
+  class ReadBatch;
+  class WriteBatch;
+
+  /** get all DOOCS properties of a ReadBatch and store the values in the targets registered with the batch. All
+   *  properties of the same location are read while holding the location lock only once, so their values are
+   *  consistent with each other. If any of these properties reports an error, all properties of that location are
+   *  read again according to the retry policy. The targets are only written if all properties of the batch could be
+   *  read, otherwise none of them is modified.
+   */
+  static void doocsGetMany(ReadBatch& batch, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** set all DOOCS properties of a WriteBatch to the values registered with the batch. All properties of the same
+   *  location are written while holding the location lock only once. If any of these properties reports an error, all
+   *  properties of that location are written again according to the retry policy.
+   */
+  static void doocsSetMany(WriteBatch& batch, const RetryPolicy& retryPolicy = getRetryPolicy());
 
   /** Function to replace the wait_for_update() function in the server. It blocks
    *  until runUpdate() has been called in the test. Public to be able to unit-test it.
@@ -122,207 +519,910 @@ class DoocsServerTestHelper {
   static int sigwait(__const sigset_t* __restrict set, int* __restrict sig);
 
  protected:
-  struct Data {
-    /** mutex and flag to trigger update() */
-    std::mutex update_mutex;
-    std::atomic<bool> allowUpdate{false};
-
-    /** mutex and flag to trigger interrupt_usr1() */
-    std::mutex sigusr1_mutex;
-    std::atomic<bool> allowSigusr1{false};
-
-    /**
-     * unique locks for controlling update() and interrupt_usr1() from the test thread. We keep this here in this
-     * static Data struct, because the use of these locks is "inverted" compared to normal lock use, i.e. we normally
-     * keep the mutex locked and only unlock it temporarily in runUpdate()/runSigusr1().
-     */
-    std::unique_lock<std::mutex> update_lock{update_mutex};
-    std::unique_lock<std::mutex> sigusr1_lock{sigusr1_mutex};
-
-    /** do not process any signals in DOOCS (to allow installing signal handlers instead) */
-    std::atomic<bool> doNotProcessSignalsInDoocs{false};
-
-    /** internal event counter */
-    int event{0};
-
-    std::atomic<bool> is_initialised{false}; // flag to check whether the server test hook has been registed
-    std::atomic<bool> do_shutdown{false};    // flag to cleanly exit wait_for_update
+  /** State of one handshake between the test thread and a server thread (update or interrupt_usr1). Both sides sleep on
+   *  the condition variable while waiting, so neither side burns CPU time. */
+  struct Handshake {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    /** number of cycles triggered by the test thread which have not yet been started by the server thread */
+    size_t requested{0};
+
+    /** true while the server thread is processing a triggered cycle, i.e. until it re-enters the wait function */
+    bool running{false};
+
+    /** true while runUpdateFor() calls update() directly, which blocks starting new batches */
+    bool selectiveUpdate{false};
+
+    /** number of cycles completed in the current batch and optional callback to be called after each cycle */
+    size_t completed{0};
+    CycleCallback onCycleCompleted;
+
+    /** number of server threads currently blocked in waitForTrigger(), used by shutdown() to wait for them to leave */
+    size_t waiting{0};
+
+    /** set when the server threads are released by shutdown() resp. Instance::release() */
+    bool shutdown{false};
+
+    /** set by Instance::retire(): no further batches can be started, the server threads stay blocked until shutdown */
+    bool retired{false};
+
+    /** state of the free-running mode, see startFreeRunning() */
+    struct {
+      bool enabled{false};
+      bool stopping{false};
+      std::chrono::nanoseconds period{0};
+      uint64_t cycles{0};
+      std::chrono::steady_clock::time_point tStart, tStop, tNext;
+    } freeRunning;
+
+    /** signal returned by sigwait() for the cycles of the current batch (only used for the sigusr1 handshake) */
+    int signal{SIGUSR1};
+
+    /** promise to be fulfilled when the current batch is complete, if it has been started asynchronously */
+    std::optional<std::promise<void>> completion;
+
+    /** timing of the current cycle and statistics */
+    std::chrono::steady_clock::time_point tTriggered, tStarted, tCompleted;
+    CycleStatistics statistics;
   };
+
+  struct Data;
+
+  /** Test side of the handshake: trigger nCycles cycles and wait until the server thread has completed them, i.e. has
+   *  re-entered the wait function after the last cycle. */
+  static void triggerAndWait(
+      Handshake& handshake, size_t nCycles, const CycleCallback& onCycleCompleted, int signal = SIGUSR1);
+
+  /** Test side of the handshake: trigger nCycles cycles and return a future which becomes ready once the server thread
+   *  has completed them. */
+  static std::future<void> triggerAsync(Handshake& handshake, size_t nCycles, const CycleCallback& onCycleCompleted);
+
+  /** Start a new batch of cycles. The handshake mutex must be locked through the passed lock. Waits until a previous
+   *  batch is complete. */
+  static void startBatch(std::unique_lock<std::mutex>& lock, Handshake& handshake, size_t nCycles,
+      const CycleCallback& onCycleCompleted, int signal = SIGUSR1);
+
+  /** Check whether no batch is currently being processed. The handshake mutex must be locked. */
+  static bool isIdle(const Handshake& handshake) {
+    return handshake.requested == 0 && !handshake.running && !handshake.selectiveUpdate &&
+        !handshake.freeRunning.enabled;
+  }
+
+  /** Server side of the handshake: mark the previous cycle as completed and wait until the next cycle is triggered.
+   *  The test thread is only woken up once all cycles of the batch are completed. Returns immediately if the server is
+   *  shutting down. */
+  static void waitForTrigger(Handshake& handshake);
+
+  /** Release the server threads waiting on the given handshakes and wait until they have left waitForTrigger(), or
+   *  until the timeout has expired */
+  static void releaseHandshakes(const std::vector<Handshake*>& handshakes, std::chrono::milliseconds timeout);
+
+  /** Server side: advance the virtual clock by advancePerUpdate (if enabled) at the start of an update cycle */
+  static void startVirtualUpdateCycle();
+
+  /** Server side: sleep until the virtual clock has reached the given time (in nanoseconds since the epoch). Returns
+   *  false without sleeping if the calling thread has to sleep in real time instead. */
+  static bool virtualSleepUntil(int64_t wakeup);
+
+  /** Sleep in real time, even if the virtual clock is enabled. Used for the helper's own waits (e.g. between retries),
+   *  which may run in server threads (e.g. inside a cycle callback) while the test thread cannot advance the clock. */
+  static void realSleep(std::chrono::nanoseconds duration);
+
+  /** Wake up all subscriptions, see subscribe() */
+  static void notifyObservers();
+
+  /** Signal the event file descriptor (if created, see getEventFd()) and wake up all subscriptions */
+  static void notifyProgress();
+
+  /** Call the function for the default instance and all further instances */
+  static void forEachInstance(const std::function<void(Instance&)>& function);
+
+  /** Server side: find the instance belonging to the given server. Falls back to the default instance for unknown
+   *  servers. */
+  static Instance& findInstance(const doocs::Server* server);
+
   static Data data;
+
+  /** Resolved address of a property: the parsed address and the pointer to the location. EqFct::get() and set() only
+   *  read the address, so it is passed to them directly for every access, also by PropertyHandle, the batches and
+   *  snapshots. */
+  struct PropertyAddress {
+    std::string name;
+    EqAdr adr;
+    EqFct* location{nullptr};
+  };
+
+  /** Parse the property name and look up the location */
+  static PropertyAddress resolveProperty(const std::string& name);
+
+  /** Access the property through the given function while holding the location lock. If an error is reported in res,
+   *  the access is retried for a while. */
+  template<typename ACCESSOR>
+  static void accessWithRetry(
+      PropertyAddress& property, EqData& res, const RetryPolicy& retryPolicy, ACCESSOR access);
+
+  /** Access the location through the given function while holding the location lock. The function returns whether the
+   *  access was successful. If not, the access is retried for a while. */
+  template<typename ACCESSOR>
+  static void accessLocationWithRetry(EqFct* location, const RetryPolicy& retryPolicy, ACCESSOR access);
+
+  /** Implementations of doocsSet(), doocsGet() and doocsGetArray() on resolved addresses */
+  template<typename TYPE>
+  static void doocsSetImpl(PropertyAddress& property, TYPE value, const RetryPolicy& retryPolicy);
+
+  template<typename TYPE>
+  static void doocsSetImpl(
+      PropertyAddress& property, const std::vector<TYPE>& value, const RetryPolicy& retryPolicy);
+
+  template<typename TYPE>
+  static TYPE doocsGetImpl(PropertyAddress& property, const RetryPolicy& retryPolicy);
+
+  template<typename TYPE>
+  static std::vector<TYPE> doocsGetArrayImpl(PropertyAddress& property, const RetryPolicy& retryPolicy);
+
+  template<typename TYPE>
+  static void doocsGetArrayImpl(PropertyAddress& property, std::vector<TYPE>& value, const RetryPolicy& retryPolicy);
+
+  template<typename TYPE>
+  static size_t doocsGetArrayImpl(PropertyAddress& property, std::span<TYPE> value, const RetryPolicy& retryPolicy);
+
+  /** Read an array property (including spectra) into res */
+  static void readArray(PropertyAddress& property, EqData& res, const RetryPolicy& retryPolicy);
+
+  /** Prepare the request data for reading an array property, so spectra always return the latest buffer */
+  static void prepareArrayRequest(EqData& ed);
+
+  /** Read an array property into res. The request data ed must have been prepared with prepareArrayRequest(). The
+   *  location must be locked by the caller and errors are not checked. */
+  static void getArrayLocked(EqFct* location, EqAdr& adr, EqData& ed, EqData& res);
+
+  /** Convert the scalar value in res into TYPE */
+  template<typename TYPE>
+  static TYPE fromEqData(EqData& res);
+
+  /** Convert the array in res into the given vector, which is resized as needed */
+  template<typename TYPE>
+  static void fromEqData(EqData& res, std::vector<TYPE>& value);
+
+  /** Copy the array in res into the given buffer. At most value.size() elements are written, the full length of the
+   *  array is returned. */
+  template<typename TYPE>
+  static size_t fromEqData(EqData& res, std::span<TYPE> value);
+
+  /** Fill ed with the array value. The DOOCS data type is chosen at compile time from TYPE, see
+   *  detail::doocsArrayType(). */
+  template<typename TYPE>
+  static void toEqData(const std::vector<TYPE>& value, EqData& ed);
+
+  /** Obtain a pointer to the array data in res, if its element type matches TYPE. Returns nullptr otherwise. */
+  template<typename TYPE>
+  static TYPE* getArrayData(EqData& res);
+
+  /** Obtain a pointer to the array data in res, if its elements have the same representation as TYPE, i.e. the same
+   *  type or an integer type of the same size and signedness (e.g. long and long long). Returns nullptr otherwise. The
+   *  types may differ, so the data must only be accessed through std::memcpy. */
+  template<typename TYPE>
+  static void* getArrayStorage(EqData& res);
+
+  /** Copy the first "length" elements of the array data in res to target, which must have room for them. The length
+   *  must not exceed res.length(). The data is copied in bulk if the element representation matches TYPE (see
+   *  getArrayStorage()), otherwise each element is converted individually. */
+  template<typename TYPE>
+  static void copyArrayData(EqData& res, TYPE* target, size_t length);
 };
 
 /**********************************************************************************************************************/
 
+/** Handshake state of one doocs::Server, obtained through DoocsServerTestHelper::getInstance(). The functions behave
+ *  like the static functions of the same name in DoocsServerTestHelper, but only act on the threads of this server.
+ *  Signals are delivered process-wide, so only the default instance can process sigusr1 cycles.
+ */
+class DoocsServerTestHelper::Instance {
+ public:
+  Instance(const Instance&) = delete;
+  Instance& operator=(const Instance&) = delete;
+
+  void runUpdate(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  std::future<void> runUpdateAsync(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  /** throws std::logic_error if this is not the default instance */
+  void runSigusr1(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  /** throws std::logic_error if this is not the default instance */
+  std::future<void> runSigusr1Async(size_t nCycles = 1, const CycleCallback& onCycleCompleted = {});
+
+  const CycleStatistics& getUpdateStatistics() const { return _update.statistics; }
+
+  const CycleStatistics& getSigusr1Statistics() const { return _sigusr1.statistics; }
+
+  void resetStatistics();
+
+  /** stop free-running mode and wait until pending batches are complete, then reset the cycle counters and timing
+   *  statistics */
+  void reset();
+
+  /** release the server threads of this instance without calling eq_exit(), e.g. at the end of a fixture. Like
+   *  shutdown(), this cannot be undone. */
+  void release(std::chrono::milliseconds timeout = std::chrono::seconds(1));
+
+  /** stop free-running mode and wait until pending batches are complete, then keep the server threads of this
+   *  instance blocked until shutdown(). Unlike release(), the threads do not return from the wait functions, so they
+   *  neither run further cycles nor advance the virtual clock. Starting a batch on a retired instance throws
+   *  std::logic_error. Like release(), this cannot be undone. */
+  void retire();
+
+  void startFreeRunning(std::chrono::nanoseconds period = std::chrono::nanoseconds(0));
+
+  void stopFreeRunning();
+
+  FreeRunningStatistics getFreeRunningStatistics();
+
+  /** the server this instance belongs to (nullptr for the HelperTest) */
+  const doocs::Server* getServer() const { return _server; }
+
+ protected:
+  friend class DoocsServerTestHelper;
+  explicit Instance(const doocs::Server* server) : _server(server) {}
+
+  /** check that sigusr1 cycles can be processed by this instance */
+  void checkSigusr1Supported() const;
+
+  std::atomic<const doocs::Server*> _server;
+  Handshake _update;
+  Handshake _sigusr1;
+};
+
+/**********************************************************************************************************************/
+
+struct DoocsServerTestHelper::Data {
+  /** state shared with the subscriptions, see subscribe() */
+  struct Observers {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    /** incremented on each observed event, only modified with the mutex held */
+    uint64_t generation{0};
+
+    /** events are only signalled while there are subscriptions */
+    std::atomic<size_t> nSubscriptions{0};
+  };
+
+  /** state of the virtual clock, see enableVirtualClock() */
+  struct VirtualClock {
+    std::atomic<bool> enabled{false};
+
+    /** virtual time in nanoseconds since the epoch, only modified with the mutex held */
+    std::atomic<int64_t> now{0};
+    std::atomic<int64_t> advancePerUpdate{0};
+
+    /** to wake up sleeping server threads when the time is advanced */
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
+  VirtualClock virtualClock;
+  Observers observers;
+
+  /** handshakes of the first initialised server, used by the static functions */
+  Instance defaultInstance{nullptr};
+
+  /** handshakes of further servers */
+  std::mutex instances_mutex;
+  std::map<const doocs::Server*, std::unique_ptr<Instance>> instances;
+
+  /** do not process any signals in DOOCS (to allow installing signal handlers instead) */
+  std::atomic<bool> doNotProcessSignalsInDoocs{false};
+
+  /** eventfd signalled on progress, created by getEventFd() (under the observers mutex) */
+  std::atomic<int> eventFd{-1};
+
+  /** set of signals the DOOCS signal thread waits for, recorded in sigwait() under the mutex of the sigusr1 handshake
+   *  of the default instance */
+  sigset_t waitedSignals{};
+  bool waitedSignalsKnown{false};
+
+  /** print timing statistics in shutdown() */
+  std::atomic<bool> printStatisticsOnShutdown{false};
+
+  std::atomic<bool> is_initialised{false}; // flag to check whether the server test hook has been registed
+
+  /** retry policy for property accesses without explicitly given policy. It is read on each access, so the current
+   *  policy is published atomically. A replaced policy is freed once the last reader has copied it. */
+  std::atomic<std::shared_ptr<const RetryPolicy>> retryPolicy{std::make_shared<const RetryPolicy>()};
+};
+
+/**********************************************************************************************************************/
+
+/** Subscription to the events observed by the DoocsServerTestHelper, obtained through
+ *  DoocsServerTestHelper::subscribe(). Events are only recorded during the lifetime of the subscription.
+ */
+class DoocsServerTestHelper::Subscription {
+ public:
+  Subscription(const Subscription&) = delete;
+  Subscription& operator=(const Subscription&) = delete;
+  ~Subscription();
+
+  /** wait until an event has been observed since the last call (resp. since subscribing). Returns false if no event
+   *  is observed until the deadline. */
+  bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+  /** same as waitUntil() with a relative timeout */
+  bool waitFor(std::chrono::milliseconds timeout) { return waitUntil(std::chrono::steady_clock::now() + timeout); }
+
+ protected:
+  friend class DoocsServerTestHelper;
+  Subscription();
+
+  uint64_t _lastGeneration;
+};
+
+/**********************************************************************************************************************/
+
+/** Values of all properties of a set of locations, see DoocsServerTestHelper::takeSnapshot(). The values are stored
+ *  back-to-back in a single buffer in a binary form, so comparing two snapshots is mostly a memory comparison.
+ */
+class DoocsServerTestHelper::Snapshot {
+ public:
+  /** number of properties in the snapshot */
+  size_t size() const { return _layout->names.size(); }
+
+  /** names of all properties in the snapshot ("//<location>/<property>") */
+  const std::vector<std::string>& getNames() const { return _layout->names; }
+
+  /** names of the properties whose value (including type, length and error state) differs in the other snapshot.
+   *  Both snapshots must contain the same properties, e.g. one has been taken from the other through
+   *  takeSnapshot(const Snapshot&). Throws std::logic_error otherwise. */
+  std::vector<std::string> diff(const Snapshot& other) const;
+
+ protected:
+  friend class DoocsServerTestHelper;
+  friend class ::ThreadedDoocsServer; // uses the layout for saveState()
+
+  /** list of properties, shared between all snapshots taken from each other */
+  struct Layout {
+    struct Location {
+      EqFct* location;
+      size_t begin, end; // range of the properties of this location
+    };
+    std::vector<Location> locations;
+    mutable std::vector<EqAdr> addresses; // EqFct::get() takes a non-const pointer but only reads the address
+    std::vector<std::string> names;
+  };
+
+  explicit Snapshot(std::shared_ptr<const Layout> layout) : _layout(std::move(layout)) {}
+
+  /** list the properties of the given locations and resolve their addresses, without reading them */
+  static std::shared_ptr<const Layout> resolve(const std::vector<std::string>& locationNames);
+
+  /** read a property of any type into res. Properties which fail to read with an empty request, like spectra, are
+   *  read as arrays with getArrayLocked(). The location must be locked by the caller. */
+  static void getLocked(EqFct* location, EqAdr& adr, EqData& res);
+
+  /** read all properties into the buffer */
+  void capture(size_t expectedBufferSize);
+
+  /** append the value of the property in binary form to the buffer */
+  static void serialise(EqData& res, std::string& buffer);
+
+  std::shared_ptr<const Layout> _layout;
+
+  /** the serialised values of all properties */
+  std::string _buffer;
+
+  /** start of the value of each property in _buffer, followed by the end of the last value */
+  std::vector<size_t> _offsets;
+};
+
+/**********************************************************************************************************************/
+
+/** Handle to a DOOCS property with pre-resolved address, obtained through DoocsServerTestHelper::getPropertyHandle().
+ *  get() and set() behave like DoocsServerTestHelper::doocsGet()/doocsGetArray() and doocsSet(), including retries and
+ *  error checking. The handle must not be used after the DOOCS server has been shut down.
+ */
+template<typename TYPE>
+class DoocsServerTestHelper::PropertyHandle {
+ public:
+  /** get the value of the property */
+  TYPE get(const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** get the value of an array property into an existing vector, reusing its memory */
+  void get(TYPE& value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** set the property to the given value */
+  void set(const TYPE& value, const RetryPolicy& retryPolicy = getRetryPolicy());
+
+  /** name of the property in the form "//<location>/<property>" */
+  const std::string& getName() const { return _property.name; }
+
+ protected:
+  friend class DoocsServerTestHelper;
+  explicit PropertyHandle(PropertyAddress property) : _property(std::move(property)) {}
+
+  PropertyAddress _property;
+};
+
+/**********************************************************************************************************************/
+
+template<typename ACCESSOR>
+void DoocsServerTestHelper::accessWithRetry(
+    PropertyAddress& property, EqData& res, const RetryPolicy& retryPolicy, ACCESSOR access) {
+  accessLocationWithRetry(property.location, retryPolicy, [&] {
+    access();
+    return res.error() == 0;
+  });
+}
+
+/**********************************************************************************************************************/
+
+template<typename ACCESSOR>
+void DoocsServerTestHelper::accessLocationWithRetry(EqFct* location, const RetryPolicy& retryPolicy, ACCESSOR access) {
+  auto start = std::chrono::steady_clock::now();
+  auto delay = std::max(retryPolicy.initialDelay, RetryPolicy::minimumDelay);
+  while(true) {
+    location->lock();
+    bool success = access();
+    location->unlock();
+    if(success || retryPolicy.failFast) {
+      break;
+    }
+    if(std::chrono::steady_clock::now() + delay - start > retryPolicy.deadline) {
+      break;
+    }
+    realSleep(delay);
+    delay = std::max(std::min(std::chrono::duration_cast<std::chrono::microseconds>(delay * retryPolicy.backoffFactor),
+                         retryPolicy.maxDelay),
+        RetryPolicy::minimumDelay);
+  }
+}
+
+/**********************************************************************************************************************/
+
 template<typename TYPE>
-void DoocsServerTestHelper::doocsSet(const std::string& name, TYPE value) {
-  EqAdr ad;
+void DoocsServerTestHelper::doocsSet(const std::string& name, TYPE value, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  doocsSetImpl<TYPE>(property, value, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::doocsSetImpl(PropertyAddress& property, TYPE value, const RetryPolicy& retryPolicy) {
   EqData ed, res;
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
   // set value
   ed.set(value);
-  size_t retryCounter = 1000; // 1000 * 10ms = 10s
-retry:
-  p->lock();
-  p->set(&ad, &ed, &res);
-  p->unlock();
-  if(res.error() != 0 && --retryCounter > 0) {
-    usleep(10000); // 10ms
-    goto retry;
-  }
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->set(&property.adr, &ed, &res); });
   // check for error
-  ASSERT(res.error() == 0, std::string("Error writing property ") + name + ": " + res.get_string());
+  ASSERT(res.error() == 0, std::string("Error writing property ") + property.name + ": " + res.get_string());
+  notifyObservers();
 }
 
 /**********************************************************************************************************************/
 
 template<typename TYPE>
-void DoocsServerTestHelper::doocsSet(const std::string& name, const std::vector<TYPE>& value) {
-  EqAdr ad;
+void DoocsServerTestHelper::doocsSet(
+    const std::string& name, const std::vector<TYPE>& value, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  doocsSetImpl(property, value, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::doocsSetImpl(
+    PropertyAddress& property, const std::vector<TYPE>& value, const RetryPolicy& retryPolicy) {
   EqData ed, res;
+  toEqData(value, ed);
+  // set spectrum
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->set(&property.adr, &ed, &res); });
+  // check for error
+  ASSERT(res.error() == 0, std::string("Error writing array property ") + property.name + ": " + res.get_string());
+  notifyObservers();
+}
+
+/**********************************************************************************************************************/
 
+template<typename TYPE>
+void DoocsServerTestHelper::toEqData(const std::vector<TYPE>& value, EqData& ed) {
   // set type and length
-  if(typeid(TYPE) == typeid(int)) {
-    ed.set_type(DATA_A_INT);
+  ed.set_type(detail::doocsArrayType<TYPE>());
+  ed.length(value.size());
+
+  // fill array data: bulk copy if the element representation matches the DOOCS type, otherwise convert each element
+  if constexpr(!std::is_same<TYPE, bool>()) {
+    void* target = getArrayStorage<TYPE>(ed);
+    if(target != nullptr) {
+      std::memcpy(target, value.data(), value.size() * sizeof(TYPE));
+      return;
+    }
   }
-  else if(typeid(TYPE) == typeid(short)) {
-    ed.set_type(DATA_A_SHORT);
+  using SetType = std::conditional_t<std::is_floating_point_v<TYPE>, TYPE,
+      std::conditional_t<(detail::doocsArrayType<TYPE>() == DATA_A_LONG), long long, int>>;
+  for(size_t i = 0; i < value.size(); i++) {
+    ed.set(static_cast<SetType>(value[i]), static_cast<int>(i));
   }
-  else if(typeid(TYPE) == typeid(long long int) || typeid(TYPE) == typeid(int32_t) || typeid(TYPE) == typeid(int64_t)) {
-    ed.set_type(DATA_A_LONG);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+TYPE DoocsServerTestHelper::doocsGet(const std::string& name, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  return doocsGetImpl<TYPE>(property, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+TYPE DoocsServerTestHelper::doocsGetImpl(PropertyAddress& property, const RetryPolicy& retryPolicy) {
+  EqData ed, res;
+  // obtain value
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->get(&property.adr, &ed, &res); });
+  // check for errors
+  ASSERT(res.error() == 0, std::string("Error reading property ") + property.name + ": " + res.get_string());
+  return fromEqData<TYPE>(res);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+TYPE DoocsServerTestHelper::fromEqData(EqData& res) {
+  // return requested type
+  if constexpr(std::is_same<TYPE, std::string>()) {
+    return res.get_string();
   }
-  else if(typeid(TYPE) == typeid(float)) {
-    ed.set_type(DATA_A_FLOAT);
+  else if constexpr(std::is_integral<TYPE>() && sizeof(TYPE) > sizeof(int)) {
+    return res.get_long();
   }
-  else if(typeid(TYPE) == typeid(double)) {
-    ed.set_type(DATA_A_DOUBLE);
+  else if constexpr(std::is_integral<TYPE>()) {
+    return res.get_int();
+  }
+  else if constexpr(std::is_same<TYPE, double>()) {
+    return res.get_double();
   }
   else {
-    ASSERT(false, std::string("Unknown data type: ") + std::string(typeid(TYPE).name()));
+    static_assert(std::is_floating_point<TYPE>(), "Wrong type passed as template argument.");
+    return res.get_float();
   }
-  ed.length(value.size());
+}
+
+/**********************************************************************************************************************/
 
-  // fill spectrum data structure
-  for(int i = 0; i < value.size(); i++) {
-    ed.set(value[i], i);
+template<typename TYPE>
+std::vector<TYPE> DoocsServerTestHelper::doocsGetArray(const std::string& name, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  return doocsGetArrayImpl<TYPE>(property, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::doocsGetArray(
+    const std::string& name, std::vector<TYPE>& value, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  doocsGetArrayImpl(property, value, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+size_t DoocsServerTestHelper::doocsGetArray(
+    const std::string& name, std::span<TYPE> value, const RetryPolicy& retryPolicy) {
+  auto property = resolveProperty(name);
+  return doocsGetArrayImpl(property, value, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+std::vector<TYPE> DoocsServerTestHelper::doocsGetArrayImpl(PropertyAddress& property, const RetryPolicy& retryPolicy) {
+  std::vector<TYPE> val;
+  doocsGetArrayImpl(property, val, retryPolicy);
+  return val;
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::doocsGetArrayImpl(
+    PropertyAddress& property, std::vector<TYPE>& value, const RetryPolicy& retryPolicy) {
+  EqData res;
+  readArray(property, res, retryPolicy);
+  fromEqData(res, value);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::fromEqData(EqData& res, std::vector<TYPE>& value) {
+  value.resize(res.length());
+  if constexpr(std::is_same<TYPE, bool>()) {
+    // std::vector<bool> has no contiguous storage
+    for(int i = 0; i < res.length(); i++) {
+      value[i] = res.get_int(i);
+    }
   }
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
-  // set spectrum
-  size_t retryCounter = 1000; // 1000 * 10ms = 10s
-retry:
-  p->lock();
-  p->set(&ad, &ed, &res);
-  p->unlock();
-  if(res.error() != 0 && --retryCounter > 0) {
-    usleep(10000); // 10ms
-    goto retry;
+  else {
+    copyArrayData(res, value.data(), value.size());
   }
-  // check for error
-  ASSERT(res.error() == 0, std::string("Error writing array property ") + name + ": " + res.get_string());
 }
 
 /**********************************************************************************************************************/
 
 template<typename TYPE>
-TYPE DoocsServerTestHelper::doocsGet(const std::string& name) {
-  EqAdr ad;
-  EqData ed, res;
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
-  // obtain value
-  size_t retryCounter = 1000; // 1000 * 10ms = 10s
-retry:
-  p->lock();
-  p->get(&ad, &ed, &res);
-  p->unlock();
-  if(res.error() != 0 && --retryCounter > 0) {
-    usleep(10000); // 10ms
-    goto retry;
+size_t DoocsServerTestHelper::doocsGetArrayImpl(
+    PropertyAddress& property, std::span<TYPE> value, const RetryPolicy& retryPolicy) {
+  EqData res;
+  readArray(property, res, retryPolicy);
+  return fromEqData(res, value);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+size_t DoocsServerTestHelper::fromEqData(EqData& res, std::span<TYPE> value) {
+  size_t length = res.length();
+  // a too small buffer is filled completely, the caller detects the truncation from the returned length
+  copyArrayData(res, value.data(), std::min(length, value.size()));
+  return length;
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+TYPE* DoocsServerTestHelper::getArrayData(EqData& res) {
+  if constexpr(std::is_same<TYPE, float>()) {
+    if(res.type() == DATA_A_FLOAT) {
+      return res.get_float_array();
+    }
+    if(res.type() == DATA_SPECTRUM && res.get_spectrum() != nullptr) {
+      return res.get_spectrum()->d_spect_array.d_spect_array_val;
+    }
   }
-  // check for errors
-  ASSERT(res.error() == 0, std::string("Error reading property ") + name + ": " + res.get_string());
-  // return requested type (note: std::string is handled in a template
-  // specialisation)
-  if(std::is_integral<TYPE>()) {
-    return res.get_int();
+  else if constexpr(std::is_same<TYPE, double>()) {
+    if(res.type() == DATA_A_DOUBLE) {
+      return res.get_double_array();
+    }
   }
-  if(std::is_floating_point<TYPE>()) {
-    return res.get_float();
+  else if constexpr(std::is_same<TYPE, int>()) {
+    if(res.type() == DATA_A_INT) {
+      return res.get_int_array();
+    }
+  }
+  else if constexpr(std::is_same<TYPE, short>()) {
+    if(res.type() == DATA_A_SHORT) {
+      return res.get_short_array();
+    }
   }
-  ASSERT(false, "Wrong type passed as tempalate argument.");
+  else if constexpr(std::is_same<TYPE, long long>()) {
+    // only the exact element type, other 64 bit types (e.g. long) would alias, see getArrayStorage()
+    if(res.type() == DATA_A_LONG) {
+      return res.get_long_array();
+    }
+  }
+  return nullptr;
 }
 
 /**********************************************************************************************************************/
 
-template<>
-std::string DoocsServerTestHelper::doocsGet<std::string>(const std::string& name);
+template<typename TYPE>
+void* DoocsServerTestHelper::getArrayStorage(EqData& res) {
+  if constexpr(std::is_integral<TYPE>() && std::is_signed<TYPE>() && sizeof(TYPE) == sizeof(long long)) {
+    return getArrayData<long long>(res);
+  }
+  else if constexpr(std::is_integral<TYPE>() && std::is_signed<TYPE>() && sizeof(TYPE) == sizeof(int)) {
+    return getArrayData<int>(res);
+  }
+  else if constexpr(std::is_integral<TYPE>() && std::is_signed<TYPE>() && sizeof(TYPE) == sizeof(short)) {
+    return getArrayData<short>(res);
+  }
+  else if constexpr(std::is_floating_point<TYPE>()) {
+    return getArrayData<TYPE>(res);
+  }
+  return nullptr;
+}
 
 /**********************************************************************************************************************/
 
 template<typename TYPE>
-std::vector<TYPE> DoocsServerTestHelper::doocsGetArray(const std::string& name) {
-  EqAdr ad;
-  EqData ed, res;
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
-  // for D_Spectrum: set IIII structure to obtain always the latest buffer
-  IIII iiii;
-  iiii.i1_data = -1;
-  iiii.i2_data = -1;
-  iiii.i3_data = -1;
-  iiii.i4_data = -1;
-  ed.set(&iiii);
-  // obtain values
-  size_t retryCounter = 1000; // 1000 * 10ms = 10s
-retry:
-  p->lock();
-
-  // Try to get the data with parameters for a spectrum
-  p->get(&ad, &ed, &res);
-  if(res.error() == eq_errors::not_implemeted) {
-    // if that fails, assume we have a plain array, and just not pass the second parameter at all
-    p->get(&ad, nullptr, &res);
-  }
-  p->unlock();
-  if(res.error() != 0 && --retryCounter > 0) {
-    usleep(10000); // 10ms
-    goto retry;
+void DoocsServerTestHelper::copyArrayData(EqData& res, TYPE* target, size_t length) {
+  const void* source = getArrayStorage<TYPE>(res);
+  if(source != nullptr) {
+    std::memcpy(target, source, length * sizeof(TYPE));
+    return;
   }
-  // check for errors
-  ASSERT(res.error() == 0, std::string("Error reading property ") + name + ": " + res.get_string());
 
-  // copy to vector and return it
-  std::vector<TYPE> val;
-  if(std::is_integral<TYPE>()) {
+  // element type does not match: convert each element
+  if constexpr(std::is_integral<TYPE>()) {
     if(res.type() != DATA_A_LONG) {
-      for(int i = 0; i < res.length(); i++) {
-        val.push_back(res.get_int(i));
+      for(size_t i = 0; i < length; i++) {
+        target[i] = res.get_int(i);
       }
     }
     else {
-      for(int i = 0; i < res.length(); i++) {
-        val.push_back(res.get_long(i));
+      for(size_t i = 0; i < length; i++) {
+        target[i] = res.get_long(i);
       }
     }
   }
-  else if(std::is_floating_point<TYPE>()) {
-    for(int i = 0; i < res.length(); i++) {
-      val.push_back(res.get_float(i));
+  else if constexpr(std::is_same<TYPE, double>()) {
+    for(size_t i = 0; i < length; i++) {
+      target[i] = res.get_double(i);
     }
   }
   else {
-    ASSERT(false, "Wrong type passed as tempalate argument.");
+    static_assert(std::is_floating_point<TYPE>(), "Wrong type passed as template argument.");
+    for(size_t i = 0; i < length; i++) {
+      target[i] = res.get_float(i);
+    }
   }
-  return val;
 }
 
+/**********************************************************************************************************************/
+
+template<typename TYPE, typename PREDICATE>
+bool DoocsServerTestHelper::waitForValue(const std::string& name, PREDICATE predicate,
+    std::chrono::milliseconds timeout, std::chrono::milliseconds pollInterval) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  // subscribe before reading the value the first time, so no change can be missed
+  auto subscription = subscribe();
+  auto property = getPropertyHandle<TYPE>(name);
+  // retries of a failing read must not extend the wait beyond the timeout
+  auto read = [&] {
+    auto retryPolicy = getRetryPolicy();
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+    retryPolicy.deadline = std::clamp(remaining, std::chrono::microseconds(0), retryPolicy.deadline);
+    return property.get(retryPolicy);
+  };
+  while(!predicate(read())) {
+    auto now = std::chrono::steady_clock::now();
+    if(now >= deadline) {
+      return false;
+    }
+    // events wake up early, the poll interval catches changes not observed by the helper
+    subscription.waitUntil(std::min<std::chrono::steady_clock::time_point>(deadline, now + pollInterval));
+  }
+  return true;
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+DoocsServerTestHelper::PropertyHandle<TYPE> DoocsServerTestHelper::getPropertyHandle(const std::string& name) {
+  return PropertyHandle<TYPE>(resolveProperty(name));
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+TYPE DoocsServerTestHelper::PropertyHandle<TYPE>::get(const RetryPolicy& retryPolicy) {
+  if constexpr(detail::IsVector<TYPE>::value) {
+    return doocsGetArrayImpl<typename TYPE::value_type>(_property, retryPolicy);
+  }
+  else {
+    return doocsGetImpl<TYPE>(_property, retryPolicy);
+  }
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::PropertyHandle<TYPE>::get(TYPE& value, const RetryPolicy& retryPolicy) {
+  static_assert(detail::IsVector<TYPE>::value, "PropertyHandle::get(TYPE&) is only available for array properties.");
+  doocsGetArrayImpl(_property, value, retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::PropertyHandle<TYPE>::set(const TYPE& value, const RetryPolicy& retryPolicy) {
+  if constexpr(detail::IsVector<TYPE>::value) {
+    doocsSetImpl(_property, value, retryPolicy);
+  }
+  else {
+    doocsSetImpl<TYPE>(_property, value, retryPolicy);
+  }
+}
+
+/**********************************************************************************************************************/
+
+/** List of DOOCS properties to be read together with DoocsServerTestHelper::doocsGetMany(). The addresses are
+ *  resolved when adding the properties, so a batch can be read repeatedly without parsing the addresses again.
+ */
+class DoocsServerTestHelper::ReadBatch {
+ public:
+  /** add a property to the batch
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "target" receives the value. It must stay valid as long as the batch is used. TYPE is either a scalar type,
+   *  std::string or a std::vector of a scalar type for array properties.
+   */
+  template<typename TYPE>
+  void add(const std::string& name, TYPE& target);
+
+  /** remove all properties from the batch */
+  void clear() { _locations.clear(); }
+
+ protected:
+  friend class DoocsServerTestHelper;
+
+  struct Entry {
+    PropertyAddress property;
+    bool isArray{false};
+    std::unique_ptr<EqData> ed{std::make_unique<EqData>()};
+    std::unique_ptr<EqData> res{std::make_unique<EqData>()};
+    std::function<void(EqData&)> store;
+  };
+
+  /** entries grouped by location */
+  std::map<EqFct*, std::vector<Entry>> _locations;
+};
+
+/**********************************************************************************************************************/
+
+/** List of DOOCS properties and values to be written together with DoocsServerTestHelper::doocsSetMany(). The values
+ *  are copied when adding the properties, so a batch can be written repeatedly.
+ */
+class DoocsServerTestHelper::WriteBatch {
+ public:
+  /** add a property to the batch
+   *  "name" is the property name in the form "//<location>/<property>"
+   *  "value" is the value to be set. TYPE is either a scalar type, std::string or a std::vector of a scalar type for
+   *  array properties.
+   */
+  template<typename TYPE>
+  void add(const std::string& name, const TYPE& value);
+
+  /** remove all properties from the batch */
+  void clear() { _locations.clear(); }
+
+ protected:
+  friend class DoocsServerTestHelper;
+
+  struct Entry {
+    PropertyAddress property;
+    std::unique_ptr<EqData> ed{std::make_unique<EqData>()};
+    std::unique_ptr<EqData> res{std::make_unique<EqData>()};
+  };
+
+  /** entries grouped by location */
+  std::map<EqFct*, std::vector<Entry>> _locations;
+};
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::ReadBatch::add(const std::string& name, TYPE& target) {
+  Entry entry;
+  entry.property = resolveProperty(name);
+  if constexpr(detail::IsVector<TYPE>::value) {
+    entry.isArray = true;
+    prepareArrayRequest(*entry.ed);
+    entry.store = [&target](EqData& res) { fromEqData(res, target); };
+  }
+  else {
+    entry.store = [&target](EqData& res) { target = fromEqData<TYPE>(res); };
+  }
+  auto* location = entry.property.location;
+  _locations[location].push_back(std::move(entry));
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+void DoocsServerTestHelper::WriteBatch::add(const std::string& name, const TYPE& value) {
+  Entry entry;
+  entry.property = resolveProperty(name);
+  if constexpr(detail::IsVector<TYPE>::value) {
+    toEqData(value, *entry.ed);
+  }
+  else {
+    entry.ed->set(value);
+  }
+  auto* location = entry.property.location;
+  _locations[location].push_back(std::move(entry));
+}
+
+/**********************************************************************************************************************/
+
 #endif // DOOCS_SERVER_TEST_HELPER_H
@@ -0,0 +1,311 @@
+#include "DoocsScenario.h"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+/*********************************************************************************************************************/
+
+namespace {
+
+  /** split the line into whitespace-separated tokens. Tokens can be quoted with "", comments start with # */
+  std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while(i < line.size()) {
+      if(std::isspace(static_cast<unsigned char>(line[i]))) {
+        ++i;
+        continue;
+      }
+      if(line[i] == '#') {
+        break;
+      }
+      if(line[i] == '"') {
+        auto end = line.find('"', i + 1);
+        if(end == std::string::npos) {
+          throw std::runtime_error("unterminated quote");
+        }
+        tokens.push_back(line.substr(i + 1, end - i - 1));
+        i = end + 1;
+        continue;
+      }
+      auto begin = i;
+      while(i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+        ++i;
+      }
+      tokens.push_back(line.substr(begin, i - begin));
+    }
+    return tokens;
+  }
+
+  /*******************************************************************************************************************/
+
+  template<typename TYPE>
+  std::optional<TYPE> parseNumber(const std::string& token) {
+    TYPE value{};
+    auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+    if(ec != std::errc() || end != token.data() + token.size()) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  /*******************************************************************************************************************/
+
+  size_t parseCount(const std::string& token) {
+    auto count = parseNumber<size_t>(token);
+    if(!count) {
+      throw std::runtime_error("invalid number of cycles '" + token + "'");
+    }
+    return *count;
+  }
+
+} // namespace
+
+/*********************************************************************************************************************/
+
+DoocsScenario DoocsScenario::fromFile(const std::string& fileName) {
+  std::ifstream file(fileName);
+  if(!file.is_open()) {
+    throw std::runtime_error("DoocsScenario: cannot open file " + fileName);
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return fromString(buffer.str(), fileName);
+}
+
+/*********************************************************************************************************************/
+
+DoocsScenario DoocsScenario::fromString(const std::string& script, const std::string& sourceName) {
+  DoocsScenario scenario;
+  scenario._source = sourceName;
+  std::istringstream stream(script);
+  std::string line;
+  size_t lineNumber = 0;
+  while(std::getline(stream, line)) {
+    ++lineNumber;
+    try {
+      scenario.parseLine(line, lineNumber);
+    }
+    catch(std::runtime_error& e) {
+      throw std::runtime_error(
+          "DoocsScenario: syntax error in " + sourceName + ":" + std::to_string(lineNumber) + ": " + e.what());
+    }
+  }
+  return scenario;
+}
+
+/*********************************************************************************************************************/
+
+void DoocsScenario::parseLine(const std::string& line, size_t lineNumber) {
+  auto tokens = tokenize(line);
+  if(tokens.empty()) {
+    return;
+  }
+
+  Command command;
+  command.line = lineNumber;
+  const auto& keyword = tokens[0];
+
+  if(keyword == "step" || keyword == "sigusr1") {
+    command.type = (keyword == "step") ? CommandType::step : CommandType::sigusr1;
+    if(tokens.size() > 2) {
+      throw std::runtime_error("too many arguments for '" + keyword + "'");
+    }
+    if(tokens.size() == 2) {
+      command.count = parseCount(tokens[1]);
+    }
+  }
+  else if(keyword == "set" || keyword == "expect" || keyword == "waitfor") {
+    if(tokens.size() < 3) {
+      throw std::runtime_error("'" + keyword + "' needs a property and a value");
+    }
+    command.property = tokens[1];
+    command.value = tokens[2];
+    command.numericValue = parseNumber<double>(command.value);
+    command.integerValue = parseNumber<int64_t>(command.value);
+
+    if(keyword == "set") {
+      command.type = CommandType::set;
+      if(tokens.size() > 3) {
+        throw std::runtime_error("too many arguments for 'set'");
+      }
+    }
+    else {
+      command.type = (keyword == "expect") ? CommandType::expect : CommandType::waitFor;
+      command.count = 1000;
+      for(size_t i = 3; i < tokens.size(); i += 2) {
+        if(i + 1 >= tokens.size()) {
+          throw std::runtime_error("missing argument after '" + tokens[i] + "'");
+        }
+        if(tokens[i] == "+-") {
+          auto tolerance = parseNumber<double>(tokens[i + 1]);
+          if(!tolerance || !command.numericValue) {
+            throw std::runtime_error("tolerance requires numeric values");
+          }
+          command.tolerance = *tolerance;
+        }
+        else if(tokens[i] == "within" && command.type == CommandType::waitFor) {
+          command.count = parseCount(tokens[i + 1]);
+        }
+        else {
+          throw std::runtime_error("unexpected argument '" + tokens[i] + "'");
+        }
+      }
+    }
+  }
+  else {
+    throw std::runtime_error("unknown command '" + keyword + "'");
+  }
+
+  _commands.push_back(std::move(command));
+}
+
+/*********************************************************************************************************************/
+
+void DoocsScenario::resolve(Command& command) {
+  switch(command.type) {
+    case CommandType::set:
+      if(command.integerValue) {
+        command.integerHandle = DoocsServerTestHelper::getPropertyHandle<int64_t>(command.property);
+      }
+      else if(command.numericValue) {
+        command.doubleHandle = DoocsServerTestHelper::getPropertyHandle<double>(command.property);
+      }
+      else {
+        command.stringHandle = DoocsServerTestHelper::getPropertyHandle<std::string>(command.property);
+      }
+      break;
+    case CommandType::expect:
+    case CommandType::waitFor:
+      if(command.integerValue) {
+        command.integerHandle = DoocsServerTestHelper::getPropertyHandle<int64_t>(command.property);
+      }
+      if(command.numericValue) {
+        command.doubleHandle = DoocsServerTestHelper::getPropertyHandle<double>(command.property);
+      }
+      else {
+        command.stringHandle = DoocsServerTestHelper::getPropertyHandle<std::string>(command.property);
+      }
+      break;
+    case CommandType::step:
+    case CommandType::sigusr1:
+      break;
+  }
+  command.resolved = true;
+}
+
+/*********************************************************************************************************************/
+
+std::optional<std::string> DoocsScenario::compare(Command& command) {
+  if(command.numericValue) {
+    auto actual = command.doubleHandle->get();
+    // Integers are compared exactly, as long as the property holds an integer. Reading a fractional value as integer
+    // would truncate it, and values outside the int64_t range cannot be read as integer. The limit is inclusive, since
+    // INT64_MAX is rounded up to 2^63 when read as double.
+    constexpr double int64Limit = 0x1p63;
+    if(command.integerValue && actual == std::trunc(actual) && actual >= -int64Limit && actual <= int64Limit) {
+      return compare(command, command.integerHandle->get());
+    }
+    return compare(command, actual);
+  }
+  return compare(command, command.stringHandle->get());
+}
+
+/*********************************************************************************************************************/
+
+std::optional<std::string> DoocsScenario::compare(const Command& command, double actual) {
+  if(std::abs(actual - *command.numericValue) <= command.tolerance) {
+    return std::nullopt;
+  }
+  std::ostringstream message;
+  message << command.property << ": expected " << command.value;
+  if(command.tolerance > 0) {
+    message << " +- " << command.tolerance;
+  }
+  message << ", got " << actual;
+  return message.str();
+}
+
+/*********************************************************************************************************************/
+
+std::optional<std::string> DoocsScenario::compare(const Command& command, int64_t actual) {
+  // the difference is computed in long double, so it cannot overflow
+  auto difference = std::abs(static_cast<long double>(actual) - static_cast<long double>(*command.integerValue));
+  if(difference <= command.tolerance) {
+    return std::nullopt;
+  }
+  std::ostringstream message;
+  message << command.property << ": expected " << command.value;
+  if(command.tolerance > 0) {
+    message << " +- " << command.tolerance;
+  }
+  message << ", got " << actual;
+  return message.str();
+}
+
+/*********************************************************************************************************************/
+
+std::optional<std::string> DoocsScenario::compare(const Command& command, const std::string& actual) {
+  if(actual == command.value) {
+    return std::nullopt;
+  }
+  return command.property + ": expected \"" + command.value + "\", got \"" + actual + "\"";
+}
+
+/*********************************************************************************************************************/
+
+std::vector<DoocsScenario::Failure> DoocsScenario::run(bool continueOnFailure) {
+  std::vector<Failure> failures;
+  for(auto& command : _commands) {
+    if(!command.resolved) {
+      resolve(command);
+    }
+
+    std::optional<std::string> error;
+    switch(command.type) {
+      case CommandType::set:
+        if(command.integerHandle) {
+          command.integerHandle->set(*command.integerValue);
+        }
+        else if(command.doubleHandle) {
+          command.doubleHandle->set(*command.numericValue);
+        }
+        else {
+          command.stringHandle->set(command.value);
+        }
+        break;
+      case CommandType::step:
+        DoocsServerTestHelper::runUpdate(command.count);
+        break;
+      case CommandType::sigusr1:
+        DoocsServerTestHelper::runSigusr1(command.count);
+        break;
+      case CommandType::expect:
+        error = compare(command);
+        break;
+      case CommandType::waitFor:
+        error = compare(command);
+        for(size_t i = 0; error && i < command.count; ++i) {
+          DoocsServerTestHelper::runUpdate();
+          error = compare(command);
+        }
+        if(error) {
+          *error += " (after " + std::to_string(command.count) + " update cycles)";
+        }
+        break;
+    }
+
+    if(error) {
+      failures.push_back({_source, command.line, *error});
+      if(!continueOnFailure) {
+        break;
+      }
+    }
+  }
+  return failures;
+}
+
+/*********************************************************************************************************************/
@@ -1,10 +1,45 @@
 #include "ThreadedDoocsServer.h"
 
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*********************************************************************************************************************/
+
+namespace {
+  std::mutex lockDirectoryMutex;
+  std::string lockDirectory;
+
+  /** DOOCS threads of a destroyed server, which stay blocked until the last server is destroyed and then terminate
+   *  with eq_exit() */
+  struct RetiredServer {
+    std::thread thread;
+    std::unique_ptr<doocs::Server> server;
+    std::vector<char*> argv;
+    std::shared_ptr<char[]> serverName;
+  };
+
+  /** started servers which have not been destroyed yet, and the retired ones, see ~ThreadedDoocsServer() */
+  std::mutex runningServersMutex;
+  size_t nRunningServers{0};
+  std::vector<RetiredServer> retiredServers;
+
+  void freeArgv(std::vector<char*>& argv) {
+    for(size_t i = 1; i < argv.size(); i++) {
+      free(argv[i]);
+    }
+    argv.clear();
+  }
+} // namespace
+
 /*********************************************************************************************************************/
 
-ThreadedDoocsServer::ThreadedDoocsServer(
-    std::string configFile, int argc, char* argv[], std::unique_ptr<doocs::Server> doocsServer, bool autoStart)
-: _configFile(std::move(configFile)), _doocsServer(std::move(doocsServer)) {
+ThreadedDoocsServer::ThreadedDoocsServer(std::string configFile, int argc, char* argv[],
+    std::unique_ptr<doocs::Server> doocsServer, bool autoStart, ConfigOverrides configOverrides)
+: _configFile(std::move(configFile)), _configOverrides(std::move(configOverrides)),
+  _doocsServer(std::move(doocsServer)) {
   assert(not _configFile.empty());
 
   auto pos = _configFile.find(".conf");
@@ -23,32 +58,24 @@ ThreadedDoocsServer::ThreadedDoocsServer(
     _argv[i] = strdup(argv[i]);
   }
 
-  // create locks to avoid accidental conflicts with concurrent instances of the same or other tests
-  _rpcNoLockFile = "/var/lock/rpcNo_" + rpcNo() + ".lock";
-  _bpnLockFile = "/var/lock/bpn_" + bpn() + ".lock";
+  // The RPC number has been claimed by the call to rpcNo() above, claim the BPN as well. Also lock the config file to
+  // avoid accidental conflicts with concurrent instances of the same or other tests.
+  bpn();
   std::ofstream give_me_a_name1(_configFileInstance, std::ofstream::out);
-  std::ofstream give_me_a_name2(_rpcNoLockFile, std::ofstream::out);
-  std::ofstream give_me_a_name3(_bpnLockFile, std::ofstream::out);
   _configMutex = boost::interprocess::file_lock(_configFileInstance.c_str());
-  _rpcNoMutex = boost::interprocess::file_lock(_rpcNoLockFile.c_str());
-  _bpnMutex = boost::interprocess::file_lock(_bpnLockFile.c_str());
   _configLock = std::unique_lock<boost::interprocess::file_lock>(_configMutex);
-  _rpcNoLock = std::unique_lock<boost::interprocess::file_lock>(_rpcNoMutex);
-  _bpnLock = std::unique_lock<boost::interprocess::file_lock>(_bpnMutex);
 
   // also need to have symlink for the executable with the new name
   boost::filesystem::create_symlink(_serverName, _serverNameInstance);
 
   // set directory name for history files
-  std::string histdir = "hist_" + _serverNameInstance;
-  setenv("HIST_DIR", histdir.c_str(), true);
+  _histDir = "hist_" + _serverNameInstance;
+  setenv("HIST_DIR", _histDir.c_str(), true);
 
   // update config file with the RPC number and BPN
-  std::string command = "sed " + _configFile + " -e 's/^SVR.RPC_NUMBER:.*$/SVR.RPC_NUMBER: " + rpcNo() +
-      "/' -e 's/^SVR.BPN:.*$/SVR.BPN: " + bpn() + "/' > " + _configFileInstance;
-  auto rc = std::system(command.c_str());
-  (void)rc;
-  assert(rc == 0);
+  _configOverrides["SVR.RPC_NUMBER"] = rpcNo();
+  _configOverrides["SVR.BPN"] = bpn();
+  writeConfigInstance();
 
   // start server if autostart requested
   if(autoStart) {
@@ -58,29 +85,221 @@ ThreadedDoocsServer::ThreadedDoocsServer(
 
 /*********************************************************************************************************************/
 
+void ThreadedDoocsServer::writeConfigInstance() {
+  std::ifstream input(_configFile);
+  assert(input.is_open());
+  std::ofstream output(_configFileInstance, std::ofstream::out | std::ofstream::trunc);
+
+  std::string line;
+  while(std::getline(input, line)) {
+    auto colon = line.find(':');
+    if(colon != std::string::npos) {
+      auto override = _configOverrides.find(std::string_view(line).substr(0, colon));
+      if(override != _configOverrides.end()) {
+        line = override->first + ": " + override->second;
+      }
+    }
+    output << line << '\n';
+  }
+  output.flush();
+  assert(output.good());
+}
+
+/*********************************************************************************************************************/
+
 void ThreadedDoocsServer::start() {
   // We have to register the wait_for_update() function of the DoocsServerTestHelper with the doocs server.
   // This is happening in DoocsServerTestHelper::initialise. We need an instance of the doocs::Server class for it.
   DoocsServerTestHelper::initialise(_doocsServer.get());
 
-  // Start the server in separate thread
-  _doocsServerThread = std::thread([&]() { _doocsServer->run(_argv.size(), _argv.data()); });
+  {
+    std::lock_guard<std::mutex> lock(runningServersMutex);
+    ++nRunningServers;
+  }
+
+  // Start the server in separate thread. The thread may outlive this object, see ~ThreadedDoocsServer().
+  _doocsServerThread = std::thread(
+      [server = _doocsServer.get(), argc = int(_argv.size()), argv = _argv.data()]() { server->run(argc, argv); });
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::reset() {
+  // wait for pending cycles first, so the server threads are blocked while the properties are restored
+  DoocsServerTestHelper::reset();
+  if(!_savedLayout) {
+    restoreConfigValues();
+  }
+  else {
+    restoreSavedState();
+  }
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::restoreConfigValues() {
+  auto trim = [](std::string_view text) {
+    auto begin = text.find_first_not_of(" \t\"");
+    if(begin == std::string_view::npos) {
+      return std::string();
+    }
+    auto end = text.find_last_not_of(" \t\"");
+    return std::string(text.substr(begin, end - begin + 1));
+  };
+
+  // the original config file is used, since the server may overwrite the instance config file when saving
+  std::ifstream input(_configFile);
+  assert(input.is_open());
+
+  std::string location;
+  std::string line;
+  while(std::getline(input, line)) {
+    auto colon = line.find(':');
+    if(colon == std::string::npos) {
+      continue;
+    }
+    auto key = trim(std::string_view(line).substr(0, colon));
+    auto value = trim(std::string_view(line).substr(colon + 1));
+    if(key == "eq_fct_name") {
+      location = value;
+      continue;
+    }
+    if(location.empty() || location.ends_with("._SVR") || key.starts_with("SVR.") || key.starts_with("eq_")) {
+      continue;
+    }
+    auto override = _configOverrides.find(key);
+    if(override != _configOverrides.end()) {
+      value = override->second;
+    }
+
+    // write the value as a string and let the property convert it, errors are ignored (see reset())
+    EqAdr adr;
+    adr.adr("//" + location + "/" + key);
+    EqFct* eqFct = eq_get(&adr);
+    if(eqFct == nullptr) {
+      continue;
+    }
+    EqData ed, res;
+    ed.set(value);
+    eqFct->lock();
+    eqFct->set(&adr, &ed, &res);
+    eqFct->unlock();
+  }
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::saveState() {
+  std::vector<std::string> locations;
+  for(auto& location : getLocationNames()) {
+    if(!location.ends_with("._SVR")) {
+      locations.push_back(std::move(location));
+    }
+  }
+
+  // the properties are listed like for a snapshot, but the values are kept as they are to be written back
+  _savedLayout = DoocsServerTestHelper::Snapshot::resolve(locations);
+  _savedValues.clear();
+  _savedValues.reserve(_savedLayout->names.size());
+  for(const auto& location : _savedLayout->locations) {
+    location.location->lock();
+    for(size_t i = location.begin; i < location.end; ++i) {
+      auto value = std::make_unique<EqData>();
+      DoocsServerTestHelper::Snapshot::getLocked(location.location, _savedLayout->addresses[i], *value);
+      if(value->error() != 0) {
+        value.reset();
+      }
+      _savedValues.push_back(std::move(value));
+    }
+    location.location->unlock();
+  }
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::restoreSavedState() {
+  // errors are ignored, e.g. for read-only properties (see reset())
+  EqData res;
+  for(const auto& location : _savedLayout->locations) {
+    location.location->lock();
+    for(size_t i = location.begin; i < location.end; ++i) {
+      if(_savedValues[i]) {
+        res.init();
+        location.location->set(&_savedLayout->addresses[i], _savedValues[i].get(), &res);
+      }
+    }
+    location.location->unlock();
+  }
+}
+
+/*********************************************************************************************************************/
+
+std::vector<std::string> ThreadedDoocsServer::getLocationNames() const {
+  std::ifstream input(_configFile);
+  assert(input.is_open());
+
+  std::vector<std::string> locations;
+  std::string line;
+  while(std::getline(input, line)) {
+    auto colon = line.find(':');
+    if(colon == std::string::npos) {
+      continue;
+    }
+    auto keyBegin = line.find_first_not_of(" \t");
+    if(line.compare(keyBegin, colon - keyBegin, "eq_fct_name") != 0) {
+      continue;
+    }
+    auto value = line.substr(colon + 1);
+    auto begin = value.find_first_not_of(" \t\"");
+    if(begin == std::string::npos) {
+      continue;
+    }
+    auto end = value.find_last_not_of(" \t\"");
+    locations.push_back(value.substr(begin, end - begin + 1));
+  }
+  return locations;
 }
 
 /*********************************************************************************************************************/
 
 ThreadedDoocsServer::~ThreadedDoocsServer() {
-  DoocsServerTestHelper::shutdown(); // calls eq_exit() and releases the locks held by the test
-  _doocsServerThread.join();
-  for(size_t i = 1; i < _argv.size(); i++) {
-    free(_argv[i]);
+  // the server has not been started if autoStart was disabled and start() has never been called
+  bool started = _doocsServerThread.joinable();
+  std::unique_lock<std::mutex> lock(runningServersMutex);
+  if(started) {
+    --nRunningServers;
+  }
+  if(nRunningServers > 0) {
+    // DOOCS can only be stopped as a whole with eq_exit(), which would tear down the other servers of this process as
+    // well. Keep the threads of this server blocked instead, they are released and joined when the last server is
+    // destroyed.
+    if(started) {
+      DoocsServerTestHelper::getInstance(_doocsServer.get()).retire();
+      retiredServers.push_back(
+          {std::move(_doocsServerThread), std::move(_doocsServer), std::move(_argv), std::move(_serverNameInstanceC)});
+    }
+    lock.unlock();
   }
+  else {
+    auto retired = std::move(retiredServers);
+    retiredServers.clear();
+    lock.unlock();
+    DoocsServerTestHelper::shutdown(); // calls eq_exit() and releases the locks held by the test
+    if(started) {
+      _doocsServerThread.join();
+    }
+    for(auto& server : retired) {
+      server.thread.join();
+      freeArgv(server.argv);
+    }
+  }
+  freeArgv(_argv);
 
   // cleanup files we have created
   boost::filesystem::remove(_configFileInstance);
   boost::filesystem::remove(_serverNameInstance);
-  boost::filesystem::remove(_rpcNoLockFile);
-  boost::filesystem::remove(_bpnLockFile);
+  _rpcNoLock.release();
+  _bpnLock.release();
 }
 
 /*********************************************************************************************************************/
@@ -88,9 +307,7 @@ ThreadedDoocsServer::~ThreadedDoocsServer() {
 std::string ThreadedDoocsServer::rpcNo() {
   std::lock_guard<std::mutex> lk(_mx_serverInfo);
   if(_rpcNo.empty()) {
-    std::random_device rd;
-    std::uniform_int_distribution<int> dist(620000000, 999999999);
-    _rpcNo = std::to_string(dist(rd));
+    _rpcNo = claimNumber("rpcNo_", std::uniform_int_distribution<int>(620000000, 999999999), 1, _rpcNoLock);
   }
 
   return _rpcNo;
@@ -101,15 +318,101 @@ std::string ThreadedDoocsServer::rpcNo() {
 std::string ThreadedDoocsServer::bpn() {
   std::lock_guard<std::mutex> lk(_mx_serverInfo);
   if(_bpn.empty()) {
-    std::random_device rd;
-    std::uniform_int_distribution<int> dist(2000, 6500);
     // range is 20000 to 65000 in steps of 10 (BPNs allocate a block of port numbers used for ZeroMQ)
     // avoid the "usual" range of 6000-10000, because there might be a normally configured server running on the
     // same machine using a BPN in that range...
-    _bpn = std::to_string(dist(rd)) + "0";
+    _bpn = claimNumber("bpn_", std::uniform_int_distribution<int>(2000, 6500), 10, _bpnLock);
   }
 
   return _bpn;
 }
 
 /*********************************************************************************************************************/
+
+std::string ThreadedDoocsServer::claimNumber(
+    const std::string& prefix, std::uniform_int_distribution<int> distribution, int factor, LockFile& lock) {
+  auto directory = getLockDirectory();
+  std::random_device rd;
+  std::mt19937 generator(rd());
+  // the ranges are large compared to the number of concurrent tests, so this limit is only reached if something is
+  // wrong with the lock directory
+  constexpr size_t maxAttempts = 10000;
+  for(size_t i = 0; i < maxAttempts; ++i) {
+    auto number = std::to_string(distribution(generator) * factor);
+    if(lock.tryLock(directory + "/" + prefix + number + ".lock")) {
+      return number;
+    }
+  }
+  throw std::runtime_error("ThreadedDoocsServer: Cannot claim a free number for '" + prefix + "' in lock directory " +
+      directory + ". Is the directory writeable?");
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::setLockDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lk(lockDirectoryMutex);
+  lockDirectory = directory;
+}
+
+/*********************************************************************************************************************/
+
+std::string ThreadedDoocsServer::getLockDirectory() {
+  std::lock_guard<std::mutex> lk(lockDirectoryMutex);
+  if(lockDirectory.empty()) {
+    const char* fromEnvironment = std::getenv("DOOCS_SERVER_TEST_LOCK_DIR");
+    if(fromEnvironment != nullptr && *fromEnvironment != 0) {
+      lockDirectory = fromEnvironment;
+    }
+    else if(access("/var/lock", W_OK) == 0) {
+      lockDirectory = "/var/lock";
+    }
+    else {
+      lockDirectory = boost::filesystem::temp_directory_path().string();
+    }
+  }
+  return lockDirectory;
+}
+
+/*********************************************************************************************************************/
+
+bool ThreadedDoocsServer::LockFile::tryLock(const std::string& path) {
+  assert(_fd < 0);
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if(fd < 0) {
+    return false;
+  }
+  if(flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    return false;
+  }
+
+  // The previous owner removes the file while still holding the lock. If that happened between our open() and
+  // flock(), we have locked a file which no longer exists under this path, so someone else could lock a new file with
+  // the same name. Hence check that the path still refers to the locked file.
+  struct stat statFd {};
+  struct stat statPath {};
+  if(fstat(fd, &statFd) != 0 || stat(path.c_str(), &statPath) != 0 || statFd.st_dev != statPath.st_dev ||
+      statFd.st_ino != statPath.st_ino) {
+    close(fd);
+    return false;
+  }
+
+  _fd = fd;
+  _path = path;
+  return true;
+}
+
+/*********************************************************************************************************************/
+
+void ThreadedDoocsServer::LockFile::release() {
+  if(_fd < 0) {
+    return;
+  }
+  // remove the file before unlocking, see tryLock()
+  unlink(_path.c_str());
+  close(_fd);
+  _fd = -1;
+  _path.clear();
+}
+
+/*********************************************************************************************************************/
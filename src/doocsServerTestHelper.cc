@@ -13,8 +13,17 @@
 #include <eq_fct.h>
 #include <unistd.h>
 
+#include <dlfcn.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+
+#include <bit>
+#include <cerrno>
+#include <cmath>
 #include <csignal>
+#include <cstring>
 #include <ctime>
+#include <utility>
 
 /**********************************************************************************************************************/
 
@@ -25,17 +34,96 @@ extern EqFctSvr* server_eq;
 
 DoocsServerTestHelper::Data DoocsServerTestHelper::data{};
 
+namespace {
+  /** set in threads which have waited for an update or sigusr1 cycle, see enableVirtualClock() */
+  thread_local bool isServerThread{false};
+
+  /** look up the original implementation of an intercepted libc function */
+  template<typename FUNCTION>
+  FUNCTION* realFunction(const char* name) {
+    auto* function = reinterpret_cast<FUNCTION*>(dlsym(RTLD_NEXT, name));
+    assert(function != nullptr);
+    return function;
+  }
+
+  int64_t toNanoseconds(const struct timespec& ts) {
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+} // namespace
+
 /**********************************************************************************************************************/
 
 extern "C" int sigwait(__const sigset_t* __restrict set, int* __restrict sig) {
-  // Using a static thread_local std::unique_lock<std::mutex> directly inside an extern "C" function seems to cause
-  // weird behaviour (unlocking during destruction happens in wrong thread or twice, seen by TSAN), hence we defer to a
-  // true C++ function here.
+  // defer to the static member function, which has access to the handshake state of the DoocsServerTestHelper
   return DoocsServerTestHelper::sigwait(set, sig);
 }
 
 /**********************************************************************************************************************/
 
+// The following functions intercept the clock and sleep functions of libc, like sigwait() above, see
+// DoocsServerTestHelper::enableVirtualClock().
+
+extern "C" int clock_gettime(clockid_t clockId, struct timespec* tp) __THROW {
+  return DoocsServerTestHelper::clock_gettime(clockId, tp);
+}
+
+extern "C" int gettimeofday(struct timeval* __restrict tv, void* __restrict tz) __THROW {
+  static auto* realGettimeofday = realFunction<decltype(::gettimeofday)>("gettimeofday");
+  if(!DoocsServerTestHelper::getVirtualClockEnabled() || !isServerThread) {
+    return realGettimeofday(tv, tz);
+  }
+  struct timespec ts {};
+  DoocsServerTestHelper::clock_gettime(CLOCK_REALTIME, &ts);
+  tv->tv_sec = ts.tv_sec;
+  tv->tv_usec = ts.tv_nsec / 1000;
+  if(tz != nullptr) {
+    std::memset(tz, 0, sizeof(struct timezone));
+  }
+  return 0;
+}
+
+extern "C" time_t time(time_t* t) __THROW {
+  struct timespec ts {};
+  DoocsServerTestHelper::clock_gettime(CLOCK_REALTIME, &ts);
+  if(t != nullptr) {
+    *t = ts.tv_sec;
+  }
+  return ts.tv_sec;
+}
+
+extern "C" int clock_nanosleep(
+    clockid_t clockId, int flags, const struct timespec* request, struct timespec* remaining) {
+  return DoocsServerTestHelper::clock_nanosleep(clockId, flags, request, remaining);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+  int rc = DoocsServerTestHelper::clock_nanosleep(CLOCK_REALTIME, 0, duration, remaining);
+  if(rc != 0) {
+    errno = rc;
+    return -1;
+  }
+  return 0;
+}
+
+extern "C" int usleep(useconds_t microseconds) {
+  struct timespec duration {};
+  duration.tv_sec = microseconds / 1000000;
+  duration.tv_nsec = (microseconds % 1000000) * 1000;
+  return nanosleep(&duration, nullptr);
+}
+
+extern "C" unsigned int sleep(unsigned int seconds) {
+  struct timespec duration {};
+  duration.tv_sec = seconds;
+  struct timespec remaining {};
+  if(nanosleep(&duration, &remaining) != 0) {
+    return remaining.tv_sec + (remaining.tv_nsec >= 500000000 ? 1 : 0);
+  }
+  return 0;
+}
+
+/**********************************************************************************************************************/
+
 int DoocsServerTestHelper::sigwait(__const sigset_t* __restrict set, int* __restrict sig) {
   // call original-equivalent version if SIGUSR1 is not in the set
   if(!sigismember(set, SIGUSR1)) {
@@ -44,37 +132,38 @@ int DoocsServerTestHelper::sigwait(__const sigset_t* __restrict set, int* __rest
     int iret = sigwaitinfo(set, &siginfo);
     *sig = siginfo.si_signo;
     // if (in the mean time) doNotProcessSignalsInDoocs has been set by the test
-    // code, wait on an empty set (-> forever)
+    // code, block until the server is shut down
     if(DoocsServerTestHelper::data.doNotProcessSignalsInDoocs) {
-      sigset_t emptySet;
-      sigemptyset(&emptySet);
-      iret = sigwaitinfo(&emptySet, &siginfo);
-      *sig = siginfo.si_signo;
+      auto& handshake = data.defaultInstance._sigusr1;
+      std::unique_lock<std::mutex> lock(handshake.mutex);
+      ++handshake.waiting;
+      handshake.cv.wait(lock, [&] { return handshake.shutdown; });
+      --handshake.waiting;
+      // let shutdown() know this thread has been released
+      handshake.cv.notify_all();
+      // the suppressed signal must not be processed during the teardown either. Like the SIGUSR1 path below, return
+      // SIGUSR1 once released, which is not in the set of this thread and hence ignored by DOOCS.
+      *sig = SIGUSR1;
     }
     return iret;
   }
 
-  // SIGUSR1 is in the set: wait until sigusr1 reqested via mutex
-  static thread_local std::unique_lock<std::mutex> sigwait_sigusr1_lock{DoocsServerTestHelper::data.sigusr1_mutex};
-
-  if(DoocsServerTestHelper::data.do_shutdown) {
-    *sig = SIGUSR1;
-    assert(sigwait_sigusr1_lock.owns_lock());
-    return 0;
+  // SIGUSR1 is in the set: wait until a signal is requested via runSigusr1() resp. runSignal()
+  auto& handshake = data.defaultInstance._sigusr1;
+  {
+    std::lock_guard<std::mutex> lock(handshake.mutex);
+    data.waitedSignals = *set;
+    data.waitedSignalsKnown = true;
   }
+  // wake up runSignal() waiting for the set
+  handshake.cv.notify_all();
+  waitForTrigger(handshake);
 
-  do {
-    if(sigwait_sigusr1_lock.owns_lock()) {
-      sigwait_sigusr1_lock.unlock();
-    }
-    usleep(1);
-    sigwait_sigusr1_lock.lock();
-  } while(!DoocsServerTestHelper::data.allowSigusr1 && !DoocsServerTestHelper::data.do_shutdown);
-  DoocsServerTestHelper::data.allowSigusr1 = false;
-
-  // return a SIGUSR1
-  *sig = SIGUSR1;
-  assert(sigwait_sigusr1_lock.owns_lock());
+  // the signal cannot change until this thread re-enters waitForTrigger(), see startBatch(). Once released by
+  // shutdown() resp. Instance::release(), always return SIGUSR1, otherwise the signal of the last batch would be
+  // handled over and over again while the server is going down.
+  std::lock_guard<std::mutex> lock(handshake.mutex);
+  *sig = handshake.shutdown ? SIGUSR1 : handshake.signal;
   return 0;
 }
 
@@ -82,6 +171,15 @@ int DoocsServerTestHelper::sigwait(__const sigset_t* __restrict set, int* __rest
 
 void DoocsServerTestHelper::initialise(doocs::Server* server) {
   server->set_update_delay_fct(&DoocsServerTestHelper::waitForUpdate);
+
+  // the first server uses the default instance, further servers get their own instance
+  std::lock_guard<std::mutex> lock(data.instances_mutex);
+  if(!data.is_initialised) {
+    data.defaultInstance._server = server;
+  }
+  else if(server != data.defaultInstance._server && data.instances.find(server) == data.instances.end()) {
+    data.instances[server] = std::unique_ptr<Instance>(new Instance(server));
+  }
   data.is_initialised = true;
 }
 
@@ -90,24 +188,74 @@ void DoocsServerTestHelper::initialise(doocs::Server* server) {
 void DoocsServerTestHelper::initialise(HelperTest*) {
   // I just put the HelperTest into the signaure to indicate that this function is not part of the regular API and
   // only used in tests of the DoocsServerTestHelper itself.
+  std::lock_guard<std::mutex> lock(data.instances_mutex);
   data.is_initialised = true;
 }
 
 /**********************************************************************************************************************/
 
-void DoocsServerTestHelper::waitForUpdate(const doocs::Server* /*server*/) {
-  if(data.do_shutdown) {
-    return;
+DoocsServerTestHelper::Instance& DoocsServerTestHelper::getInstance(const doocs::Server* server) {
+  if(!data.is_initialised) {
+    throw std::logic_error("DoocsServerTestHelper::getInstance() called  without calling initialise() first.");
+  }
+  if(server == nullptr || server == data.defaultInstance._server) {
+    return data.defaultInstance;
+  }
+  std::lock_guard<std::mutex> lock(data.instances_mutex);
+  auto instance = data.instances.find(server);
+  if(instance == data.instances.end()) {
+    throw std::logic_error("DoocsServerTestHelper::getInstance() called for a server which has not been initialised.");
+  }
+  return *instance->second;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Instance& DoocsServerTestHelper::findInstance(const doocs::Server* server) {
+  // fast path for the common case of a single server
+  if(server == data.defaultInstance._server) {
+    return data.defaultInstance;
   }
-  static thread_local std::unique_lock<std::mutex> waitForUpdate_update_lock{DoocsServerTestHelper::data.update_mutex};
-  do {
-    if(waitForUpdate_update_lock.owns_lock()) {
-      waitForUpdate_update_lock.unlock();
+  std::lock_guard<std::mutex> lock(data.instances_mutex);
+  auto instance = data.instances.find(server);
+  if(instance == data.instances.end()) {
+    return data.defaultInstance;
+  }
+  return *instance->second;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::forEachInstance(const std::function<void(Instance&)>& function) {
+  function(data.defaultInstance);
+  std::vector<Instance*> instances;
+  {
+    std::lock_guard<std::mutex> lock(data.instances_mutex);
+    for(auto& [server, instance] : data.instances) {
+      instances.push_back(instance.get());
     }
-    usleep(1);
-    waitForUpdate_update_lock.lock();
-  } while(!data.allowUpdate && !data.do_shutdown);
-  data.allowUpdate = false;
+  }
+  // instances are never removed, so the function can be called without holding the lock
+  for(auto* instance : instances) {
+    function(*instance);
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::waitForUpdate(const doocs::Server* server) {
+  waitForTrigger(findInstance(server)._update);
+  startVirtualUpdateCycle();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::startVirtualUpdateCycle() {
+  // each update cycle advances the virtual clock, if requested
+  auto advancePerUpdate = data.virtualClock.advancePerUpdate.load();
+  if(data.virtualClock.enabled && advancePerUpdate != 0) {
+    advanceVirtualClock(std::chrono::nanoseconds(advancePerUpdate));
+  }
 }
 
 /**********************************************************************************************************************/
@@ -119,35 +267,410 @@ void DoocsServerTestHelper::setDoNotProcessSignalsInDoocs(bool _doNotProcessSign
 /**********************************************************************************************************************/
 
 void DoocsServerTestHelper::runSigusr1() {
-  data.allowSigusr1 = true;
-  do {
-    if(data.sigusr1_lock.owns_lock()) {
-      data.sigusr1_lock.unlock();
-    }
-    usleep(1);
-    data.sigusr1_lock.lock();
-  } while(data.allowSigusr1);
+  runSigusr1(1);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::runSigusr1(size_t nCycles, const CycleCallback& onCycleCompleted) {
+  data.defaultInstance.runSigusr1(nCycles, onCycleCompleted);
 }
 
 /**********************************************************************************************************************/
 
 void DoocsServerTestHelper::runUpdate() {
+  runUpdate(1);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::runUpdate(size_t nCycles, const CycleCallback& onCycleCompleted) {
   if(!data.is_initialised) {
     throw std::logic_error("DoocsServerTestHelper::runUpdate() called  without calling initialise() first.");
   }
-  data.allowUpdate = true;
-  do {
-    if(data.update_lock.owns_lock()) {
-      data.update_lock.unlock();
+  data.defaultInstance.runUpdate(nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+std::future<void> DoocsServerTestHelper::runSigusr1Async(size_t nCycles, const CycleCallback& onCycleCompleted) {
+  return data.defaultInstance.runSigusr1Async(nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::runSignal(int sig, std::chrono::milliseconds timeout) {
+  auto& handshake = data.defaultInstance._sigusr1;
+  {
+    // The set is recorded when the signal thread enters sigwait() with SIGUSR1 in the set. Only such a thread serves
+    // the handshake, so without it the signal could never be delivered.
+    std::unique_lock<std::mutex> lock(handshake.mutex);
+    if(!handshake.cv.wait_for(lock, timeout, [&] { return data.waitedSignalsKnown || handshake.shutdown; })) {
+      throw std::logic_error("DoocsServerTestHelper::runSignal(): no DOOCS signal thread waits for SIGUSR1.");
+    }
+    if(data.waitedSignalsKnown && sigismember(&data.waitedSignals, sig) != 1) {
+      throw std::logic_error("DoocsServerTestHelper::runSignal(): signal " + std::to_string(sig) +
+          " is not waited for by the DOOCS signal thread.");
+    }
+  }
+  triggerAndWait(handshake, 1, {}, sig);
+}
+
+/**********************************************************************************************************************/
+
+std::future<void> DoocsServerTestHelper::runUpdateAsync(size_t nCycles, const CycleCallback& onCycleCompleted) {
+  if(!data.is_initialised) {
+    throw std::logic_error("DoocsServerTestHelper::runUpdateAsync() called  without calling initialise() first.");
+  }
+  return data.defaultInstance.runUpdateAsync(nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::runUpdateFor(const std::vector<EqFct*>& locations, size_t nCycles) {
+  if(!data.is_initialised) {
+    throw std::logic_error("DoocsServerTestHelper::runUpdateFor() called  without calling initialise() first.");
+  }
+  auto& handshake = data.defaultInstance._update;
+  auto setSelectiveUpdate = [&](bool value) {
+    std::lock_guard<std::mutex> lock(handshake.mutex);
+    handshake.selectiveUpdate = value;
+    handshake.cv.notify_all();
+  };
+
+  // wait until a running batch is complete, then block new batches while update() is called directly
+  {
+    std::unique_lock<std::mutex> lock(handshake.mutex);
+    if(handshake.freeRunning.enabled) {
+      // waiting would block forever, since free-running is only stopped explicitly
+      throw std::logic_error("DoocsServerTestHelper::runUpdateFor() called while free-running.");
+    }
+    handshake.cv.wait(lock, [&] { return isIdle(handshake) || handshake.shutdown; });
+    if(handshake.shutdown) {
+      return;
+    }
+    handshake.selectiveUpdate = true;
+  }
+
+  // update() is called as if from the update thread, so it sees the virtual time
+  bool wasServerThread = std::exchange(isServerThread, true);
+  auto finish = [&] {
+    isServerThread = wasServerThread;
+    setSelectiveUpdate(false);
+  };
+
+  try {
+    for(size_t i = 0; i < nCycles; ++i) {
+      startVirtualUpdateCycle();
+      auto tStarted = std::chrono::steady_clock::now();
+      for(auto* location : locations) {
+        location->lock();
+        location->update();
+        location->unlock();
+      }
+      {
+        std::lock_guard<std::mutex> lock(handshake.mutex);
+        handshake.statistics.processing.record(std::chrono::steady_clock::now() - tStarted);
+      }
+      notifyProgress();
+    }
+  }
+  catch(...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::runUpdateFor(const std::vector<std::string>& locationNames, size_t nCycles) {
+  std::vector<EqFct*> locations;
+  locations.reserve(locationNames.size());
+  for(const auto& name : locationNames) {
+    EqAdr adr;
+    adr.adr("//" + name + "/");
+    auto* location = eq_get(&adr);
+    ASSERT(location != nullptr, std::string("Could not get location ") + name);
+    locations.push_back(location);
+  }
+  runUpdateFor(locations, nCycles);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::startFreeRunning(std::chrono::nanoseconds period) {
+  if(!data.is_initialised) {
+    throw std::logic_error("DoocsServerTestHelper::startFreeRunning() called  without calling initialise() first.");
+  }
+  data.defaultInstance.startFreeRunning(period);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::stopFreeRunning() {
+  data.defaultInstance.stopFreeRunning();
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::FreeRunningStatistics DoocsServerTestHelper::getFreeRunningStatistics() {
+  return data.defaultInstance.getFreeRunningStatistics();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::runUpdate(size_t nCycles, const CycleCallback& onCycleCompleted) {
+  triggerAndWait(_update, nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+std::future<void> DoocsServerTestHelper::Instance::runUpdateAsync(
+    size_t nCycles, const CycleCallback& onCycleCompleted) {
+  return triggerAsync(_update, nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::runSigusr1(size_t nCycles, const CycleCallback& onCycleCompleted) {
+  checkSigusr1Supported();
+  triggerAndWait(_sigusr1, nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+std::future<void> DoocsServerTestHelper::Instance::runSigusr1Async(
+    size_t nCycles, const CycleCallback& onCycleCompleted) {
+  checkSigusr1Supported();
+  return triggerAsync(_sigusr1, nCycles, onCycleCompleted);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::checkSigusr1Supported() const {
+  if(this != &data.defaultInstance) {
+    throw std::logic_error("DoocsServerTestHelper: sigusr1 cycles can only be run for the default instance.");
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::resetStatistics() {
+  for(auto* handshake : {&_update, &_sigusr1}) {
+    handshake->statistics.wakeup.reset();
+    handshake->statistics.processing.reset();
+    handshake->statistics.completion.reset();
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::reset() {
+  // otherwise the handshake never becomes idle
+  stopFreeRunning();
+  for(auto* handshake : {&_update, &_sigusr1}) {
+    std::unique_lock<std::mutex> lock(handshake->mutex);
+    handshake->cv.wait(lock, [&] { return isIdle(*handshake) || handshake->shutdown; });
+    handshake->completed = 0;
+  }
+  resetStatistics();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::startFreeRunning(std::chrono::nanoseconds period) {
+  std::unique_lock<std::mutex> lock(_update.mutex);
+  _update.cv.wait(lock, [&] { return isIdle(_update) || _update.shutdown; });
+  if(_update.retired) {
+    throw std::logic_error("DoocsServerTestHelper: cannot start free-running on a retired instance.");
+  }
+  auto& freeRunning = _update.freeRunning;
+  freeRunning.enabled = true;
+  freeRunning.period = period;
+  freeRunning.cycles = 0;
+  freeRunning.tStart = std::chrono::steady_clock::now();
+  freeRunning.tNext = freeRunning.tStart;
+  _update.cv.notify_all();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::stopFreeRunning() {
+  std::unique_lock<std::mutex> lock(_update.mutex);
+  auto& freeRunning = _update.freeRunning;
+  if(!freeRunning.enabled) {
+    return;
+  }
+  freeRunning.enabled = false;
+  freeRunning.stopping = true;
+  freeRunning.tStop = std::chrono::steady_clock::now();
+  _update.cv.notify_all();
+  _update.cv.wait(lock, [&] { return _update.waiting > 0 || _update.shutdown; });
+  freeRunning.stopping = false;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::FreeRunningStatistics DoocsServerTestHelper::Instance::getFreeRunningStatistics() {
+  std::lock_guard<std::mutex> lock(_update.mutex);
+  auto& freeRunning = _update.freeRunning;
+  FreeRunningStatistics statistics;
+  statistics.cycles = freeRunning.cycles;
+  auto tEnd = freeRunning.enabled ? std::chrono::steady_clock::now() : freeRunning.tStop;
+  statistics.duration = tEnd - freeRunning.tStart;
+  return statistics;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::release(std::chrono::milliseconds timeout) {
+  releaseHandshakes({&_update, &_sigusr1}, timeout);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Instance::retire() {
+  stopFreeRunning();
+  for(auto* handshake : {&_update, &_sigusr1}) {
+    std::unique_lock<std::mutex> lock(handshake->mutex);
+    handshake->cv.wait(lock, [&] { return isIdle(*handshake) || handshake->shutdown; });
+    handshake->retired = true;
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::triggerAndWait(
+    Handshake& handshake, size_t nCycles, const CycleCallback& onCycleCompleted, int signal) {
+  if(nCycles == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(handshake.mutex);
+  startBatch(lock, handshake, nCycles, onCycleCompleted, signal);
+  handshake.cv.wait(lock, [&] { return isIdle(handshake) || handshake.shutdown; });
+  if(!handshake.shutdown) {
+    handshake.statistics.completion.record(std::chrono::steady_clock::now() - handshake.tCompleted);
+  }
+}
+
+/**********************************************************************************************************************/
+
+std::future<void> DoocsServerTestHelper::triggerAsync(
+    Handshake& handshake, size_t nCycles, const CycleCallback& onCycleCompleted) {
+  std::promise<void> completion;
+  auto future = completion.get_future();
+  if(nCycles == 0) {
+    completion.set_value();
+    return future;
+  }
+  std::unique_lock<std::mutex> lock(handshake.mutex);
+  startBatch(lock, handshake, nCycles, onCycleCompleted);
+  if(handshake.shutdown) {
+    completion.set_value();
+    return future;
+  }
+  handshake.completion = std::move(completion);
+  return future;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::startBatch(std::unique_lock<std::mutex>& lock, Handshake& handshake, size_t nCycles,
+    const CycleCallback& onCycleCompleted, int signal) {
+  // a previous batch might still be running if it has been started asynchronously
+  handshake.cv.wait(lock, [&] { return isIdle(handshake) || handshake.shutdown; });
+  if(handshake.retired && !handshake.shutdown) {
+    // the server threads would never pick up the batch
+    throw std::logic_error("DoocsServerTestHelper: cannot run cycles on a retired instance.");
+  }
+  handshake.signal = signal;
+  handshake.requested = nCycles;
+  handshake.completed = 0;
+  handshake.onCycleCompleted = onCycleCompleted;
+  handshake.tTriggered = std::chrono::steady_clock::now();
+  handshake.cv.notify_all();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::waitForTrigger(Handshake& handshake) {
+  isServerThread = true;
+  std::unique_lock<std::mutex> lock(handshake.mutex);
+  if(handshake.running) {
+    // the previous cycle is complete
+    if(handshake.onCycleCompleted) {
+      // the callback is not modified by the test thread while a batch is running, so it can be called unlocked
+      lock.unlock();
+      handshake.onCycleCompleted(handshake.completed);
+      lock.lock();
+    }
+    ++handshake.completed;
+    handshake.running = false;
+    handshake.tCompleted = std::chrono::steady_clock::now();
+    handshake.statistics.processing.record(handshake.tCompleted - handshake.tStarted);
+    notifyProgress();
+    // the next cycle of the batch is triggered right away
+    handshake.tTriggered = handshake.tCompleted;
+    if(handshake.requested == 0) {
+      // the batch is complete: wake up the test thread waiting in triggerAndWait() resp. fulfil the promise
+      handshake.onCycleCompleted = nullptr;
+      handshake.signal = SIGUSR1;
+      if(handshake.completion) {
+        handshake.completion->set_value();
+        handshake.completion.reset();
+        // separate event for the completed batch, so an event loop finds the future ready once woken up
+        notifyProgress();
+      }
+      handshake.cv.notify_all();
     }
-    usleep(1);
-    data.update_lock.lock();
-  } while(data.allowUpdate);
+  }
+  auto& freeRunning = handshake.freeRunning;
+  if(freeRunning.enabled) {
+    // free-running mode: start the next cycle right away resp. at the next period, unless stopped meanwhile
+    if(freeRunning.period.count() > 0) {
+      handshake.cv.wait_until(lock, freeRunning.tNext, [&] { return !freeRunning.enabled || handshake.shutdown; });
+      freeRunning.tNext = std::max(freeRunning.tNext + freeRunning.period, std::chrono::steady_clock::now());
+    }
+    if(handshake.shutdown) {
+      return;
+    }
+    if(freeRunning.enabled) {
+      // the previous free-running cycle is complete
+      ++freeRunning.cycles;
+      notifyProgress();
+      return;
+    }
+  }
+  ++handshake.waiting;
+  if(freeRunning.stopping) {
+    // let stopFreeRunning() know this thread is back in lock-step mode
+    handshake.cv.notify_all();
+  }
+  // a retired instance keeps its threads here until the shutdown
+  handshake.cv.wait(lock, [&] {
+    return handshake.shutdown || (!handshake.retired && (handshake.requested > 0 || handshake.freeRunning.enabled));
+  });
+  --handshake.waiting;
+  if(handshake.shutdown) {
+    // let shutdown() know this thread has been released
+    handshake.cv.notify_all();
+    return;
+  }
+  if(freeRunning.enabled) {
+    ++freeRunning.cycles;
+    freeRunning.tNext = std::chrono::steady_clock::now() + freeRunning.period;
+    return;
+  }
+  --handshake.requested;
+  handshake.running = true;
+  handshake.tStarted = std::chrono::steady_clock::now();
+  handshake.statistics.wakeup.record(handshake.tStarted - handshake.tTriggered);
 }
 
 /**********************************************************************************************************************/
 
-void DoocsServerTestHelper::shutdown() {
+void DoocsServerTestHelper::shutdown(std::chrono::milliseconds timeout) {
   int myBuildPhase;
 
   extern int build_phase;
@@ -157,27 +680,627 @@ void DoocsServerTestHelper::shutdown() {
     myBuildPhase = build_phase;
   }
 
+  // wake up server threads sleeping in virtual time first, otherwise they would stay blocked during eq_exit()
+  disableVirtualClock();
+
   // The global variable "myBuildPhase" from DOOCS determines the state the DOOCS server is in. If build_phase is < 2,
   // eq_exit() will immediately terminate the process by calling exit(), which is not wanted here.
   if(myBuildPhase > 1) {
     eq_exit();
   }
-  usleep(100000);
-  data.do_shutdown = true;
-  data.allowUpdate = true;
-  data.allowSigusr1 = true;
-  if(data.update_lock.owns_lock()) {
-    data.update_lock.unlock();
+  if(data.printStatisticsOnShutdown) {
+    printStatistics();
+  }
+
+  std::vector<Handshake*> handshakes;
+  forEachInstance([&](Instance& instance) {
+    handshakes.push_back(&instance._update);
+    handshakes.push_back(&instance._sigusr1);
+  });
+  releaseHandshakes(handshakes, timeout);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::releaseHandshakes(
+    const std::vector<Handshake*>& handshakes, std::chrono::milliseconds timeout) {
+  // wake up all threads waiting on either side of the handshakes. The mutexes must be held while setting the flag and
+  // notifying, otherwise a thread which has just checked the flag might miss the notification.
+  for(auto* handshake : handshakes) {
+    std::lock_guard<std::mutex> lock(handshake->mutex);
+    handshake->shutdown = true;
+    if(handshake->completion) {
+      handshake->completion->set_value();
+      handshake->completion.reset();
+    }
+    handshake->cv.notify_all();
+  }
+
+  // wait until the server threads have actually left the wait functions, so DOOCS can proceed with its exit
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  for(auto* handshake : handshakes) {
+    std::unique_lock<std::mutex> lock(handshake->mutex);
+    handshake->cv.wait_until(lock, deadline, [&] { return handshake->waiting == 0; });
+  }
+  notifyProgress();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::reset() {
+  forEachInstance([](Instance& instance) { instance.reset(); });
+  setRetryPolicy(RetryPolicy());
+  data.doNotProcessSignalsInDoocs = false;
+  disableVirtualClock();
+}
+
+/**********************************************************************************************************************/
+
+const DoocsServerTestHelper::CycleStatistics& DoocsServerTestHelper::getUpdateStatistics() {
+  return data.defaultInstance._update.statistics;
+}
+
+/**********************************************************************************************************************/
+
+const DoocsServerTestHelper::CycleStatistics& DoocsServerTestHelper::getSigusr1Statistics() {
+  return data.defaultInstance._sigusr1.statistics;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::resetStatistics() {
+  forEachInstance([](Instance& instance) { instance.resetStatistics(); });
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::printStatistics(std::ostream& stream) {
+  auto printHistogram = [&](const std::string& name, const LatencyHistogram& histogram) {
+    auto us = [&](double p) { return std::to_string(histogram.percentile(p).count() / 1000.) + " us"; };
+    stream << "  " << name << ": n = " << histogram.count() << ", p50 = " << us(0.5) << ", p90 = " << us(0.9)
+           << ", p99 = " << us(0.99) << ", max = " << us(1.) << std::endl;
+  };
+  for(auto [name, statistics] : {std::make_pair("update", &data.defaultInstance._update.statistics),
+          std::make_pair("interrupt_usr1", &data.defaultInstance._sigusr1.statistics)}) {
+    stream << "DoocsServerTestHelper " << name << " cycle statistics:" << std::endl;
+    printHistogram("wakeup    ", statistics->wakeup);
+    printHistogram("processing", statistics->processing);
+    printHistogram("completion", statistics->completion);
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::setPrintStatisticsOnShutdown(bool enable) {
+  data.printStatisticsOnShutdown = enable;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Subscription DoocsServerTestHelper::subscribe() {
+  return Subscription();
+}
+
+/**********************************************************************************************************************/
+
+int DoocsServerTestHelper::getEventFd() {
+  std::lock_guard<std::mutex> lock(data.observers.mutex);
+  if(data.eventFd < 0) {
+    data.eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(data.eventFd < 0) {
+      throw std::runtime_error(
+          std::string("DoocsServerTestHelper::getEventFd(): Cannot create eventfd: ") + std::strerror(errno));
+    }
+  }
+  return data.eventFd;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::notifyProgress() {
+  int fd = data.eventFd;
+  if(fd >= 0) {
+    uint64_t one = 1;
+    // cannot fail unless the counter overflows, in which case the descriptor is readable anyway
+    [[maybe_unused]] auto written = ::write(fd, &one, sizeof(one));
+  }
+  notifyObservers();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::notifyObservers() {
+  auto& observers = data.observers;
+  if(observers.nSubscriptions == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(observers.mutex);
+  ++observers.generation;
+  observers.cv.notify_all();
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Subscription::Subscription() {
+  auto& observers = data.observers;
+  std::lock_guard<std::mutex> lock(observers.mutex);
+  ++observers.nSubscriptions;
+  _lastGeneration = observers.generation;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Subscription::~Subscription() {
+  --data.observers.nSubscriptions;
+}
+
+/**********************************************************************************************************************/
+
+bool DoocsServerTestHelper::Subscription::waitUntil(std::chrono::steady_clock::time_point deadline) {
+  auto& observers = data.observers;
+  std::unique_lock<std::mutex> lock(observers.mutex);
+  if(!observers.cv.wait_until(lock, deadline, [&] { return observers.generation != _lastGeneration; })) {
+    return false;
+  }
+  _lastGeneration = observers.generation;
+  return true;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Snapshot DoocsServerTestHelper::takeSnapshot(const std::vector<std::string>& locationNames) {
+  Snapshot snapshot(Snapshot::resolve(locationNames));
+  snapshot.capture(0);
+  return snapshot;
+}
+
+/**********************************************************************************************************************/
+
+std::shared_ptr<const DoocsServerTestHelper::Snapshot::Layout> DoocsServerTestHelper::Snapshot::resolve(
+    const std::vector<std::string>& locationNames) {
+  auto layout = std::make_shared<Layout>();
+  for(const auto& name : locationNames) {
+    EqAdr adr;
+    adr.adr("//" + name + "/");
+    auto* location = eq_get(&adr);
+    ASSERT(location != nullptr, std::string("Could not get location ") + name);
+
+    // the property list contains one entry per property, starting with the property name followed by a description
+    EqData names;
+    location->lock();
+    location->names(&adr, &names);
+    location->unlock();
+    Layout::Location entry{location, layout->names.size(), 0};
+    for(int i = 0; i < names.length(); ++i) {
+      auto property = names.get_string(i);
+      property = property.substr(0, property.find_first_of(" \t"));
+      if(property.empty()) {
+        continue;
+      }
+      layout->names.push_back("//" + name + "/" + property);
+      layout->addresses.emplace_back();
+      layout->addresses.back().adr(layout->names.back());
+    }
+    entry.end = layout->names.size();
+    layout->locations.push_back(entry);
+  }
+  return layout;
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::Snapshot DoocsServerTestHelper::takeSnapshot(const Snapshot& previous) {
+  Snapshot snapshot(previous._layout);
+  snapshot.capture(previous._buffer.size());
+  return snapshot;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Snapshot::capture(size_t expectedBufferSize) {
+  _buffer.reserve(expectedBufferSize);
+  _offsets.reserve(_layout->names.size() + 1);
+  EqData res;
+  for(const auto& location : _layout->locations) {
+    location.location->lock();
+    for(size_t i = location.begin; i < location.end; ++i) {
+      res.init();
+      getLocked(location.location, _layout->addresses[i], res);
+      _offsets.push_back(_buffer.size());
+      serialise(res, _buffer);
+    }
+    location.location->unlock();
+  }
+  _offsets.push_back(_buffer.size());
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Snapshot::getLocked(EqFct* location, EqAdr& adr, EqData& res) {
+  EqData ed;
+  location->get(&adr, &ed, &res);
+  if(res.error() != 0) {
+    prepareArrayRequest(ed);
+    res.init();
+    getArrayLocked(location, adr, ed, res);
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::Snapshot::serialise(EqData& res, std::string& buffer) {
+  auto append = [&](const auto& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto appendArray = [&](auto* array, int length, auto getElement) {
+    if(array != nullptr) {
+      buffer.append(reinterpret_cast<const char*>(array), length * sizeof(*array));
+      return;
+    }
+    for(int i = 0; i < length; ++i) {
+      append(getElement(i));
+    }
+  };
+
+  int type = res.type();
+  int length = res.length();
+  append(type);
+  append(length);
+  append(res.error());
+  switch(type) {
+    case DATA_INT:
+    case DATA_BOOL:
+    case DATA_SHORT:
+    case DATA_LONG:
+      append(res.get_long());
+      break;
+    case DATA_FLOAT:
+    case DATA_DOUBLE:
+      append(res.get_double());
+      break;
+    case DATA_A_FLOAT:
+    case DATA_SPECTRUM:
+      appendArray(getArrayData<float>(res), length, [&](int i) { return res.get_float(i); });
+      break;
+    case DATA_A_DOUBLE:
+      appendArray(getArrayData<double>(res), length, [&](int i) { return res.get_double(i); });
+      break;
+    case DATA_A_INT:
+    case DATA_A_BOOL:
+    case DATA_A_BYTE:
+      appendArray(getArrayData<int>(res), length, [&](int i) { return res.get_int(i); });
+      break;
+    case DATA_A_SHORT:
+      appendArray(getArrayData<short>(res), length, [&](int i) { return res.get_int(i); });
+      break;
+    case DATA_A_LONG:
+      appendArray(getArrayData<long long>(res), length, [&](int i) { return res.get_long(i); });
+      break;
+    default: {
+      // strings and all other types are compared through their string representation
+      auto value = res.get_string();
+      append(value.size());
+      buffer.append(value);
+    }
+  }
+}
+
+/**********************************************************************************************************************/
+
+std::vector<std::string> DoocsServerTestHelper::Snapshot::diff(const Snapshot& other) const {
+  if(_layout != other._layout && _layout->names != other._layout->names) {
+    throw std::logic_error("DoocsServerTestHelper::Snapshot::diff(): snapshots contain different properties");
+  }
+  std::vector<std::string> changed;
+  if(_buffer == other._buffer) {
+    return changed;
+  }
+  for(size_t i = 0; i < size(); ++i) {
+    auto a = std::string_view(_buffer).substr(_offsets[i], _offsets[i + 1] - _offsets[i]);
+    auto b = std::string_view(other._buffer).substr(other._offsets[i], other._offsets[i + 1] - other._offsets[i]);
+    if(a != b) {
+      changed.push_back(_layout->names[i]);
+    }
+  }
+  return changed;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::enableVirtualClock(
+    std::chrono::nanoseconds advancePerUpdate, std::chrono::system_clock::time_point start) {
+  auto& clock = data.virtualClock;
+  std::lock_guard<std::mutex> lock(clock.mutex);
+  clock.now = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+  clock.advancePerUpdate = advancePerUpdate.count();
+  clock.enabled = true;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::disableVirtualClock() {
+  auto& clock = data.virtualClock;
+  std::lock_guard<std::mutex> lock(clock.mutex);
+  clock.enabled = false;
+  clock.cv.notify_all();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::advanceVirtualClock(std::chrono::nanoseconds duration) {
+  auto& clock = data.virtualClock;
+  std::lock_guard<std::mutex> lock(clock.mutex);
+  clock.now += duration.count();
+  clock.cv.notify_all();
+}
+
+/**********************************************************************************************************************/
+
+bool DoocsServerTestHelper::getVirtualClockEnabled() {
+  return data.virtualClock.enabled;
+}
+
+/**********************************************************************************************************************/
+
+std::chrono::system_clock::time_point DoocsServerTestHelper::getVirtualClockTime() {
+  return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      std::chrono::nanoseconds(data.virtualClock.now.load())));
+}
+
+/**********************************************************************************************************************/
+
+int DoocsServerTestHelper::clock_gettime(clockid_t clockId, struct timespec* tp) {
+  // Note: this may be called before the static data has been constructed, which is fine since it is zero-initialised.
+  // Only the server threads see the virtual time, since only their sleeps are done in virtual time.
+  if(isServerThread && data.virtualClock.enabled && (clockId == CLOCK_REALTIME || clockId == CLOCK_REALTIME_COARSE) &&
+      tp != nullptr) {
+    auto now = data.virtualClock.now.load();
+    tp->tv_sec = now / 1000000000;
+    tp->tv_nsec = now % 1000000000;
+    return 0;
+  }
+  static auto* realClockGettime = realFunction<decltype(::clock_gettime)>("clock_gettime");
+  return realClockGettime(clockId, tp);
+}
+
+/**********************************************************************************************************************/
+
+int DoocsServerTestHelper::clock_nanosleep(
+    clockid_t clockId, int flags, const struct timespec* request, struct timespec* remaining) {
+  if(request != nullptr) {
+    if(flags & TIMER_ABSTIME) {
+      // absolute sleeps can only be done in virtual time for the wall clock
+      if(clockId == CLOCK_REALTIME && virtualSleepUntil(toNanoseconds(*request))) {
+        return 0;
+      }
+    }
+    else if(virtualSleepUntil(data.virtualClock.now + toNanoseconds(*request))) {
+      if(remaining != nullptr) {
+        remaining->tv_sec = 0;
+        remaining->tv_nsec = 0;
+      }
+      return 0;
+    }
+  }
+  static auto* realClockNanosleep = realFunction<decltype(::clock_nanosleep)>("clock_nanosleep");
+  return realClockNanosleep(clockId, flags, request, remaining);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::realSleep(std::chrono::nanoseconds duration) {
+  static auto* realClockNanosleep = realFunction<decltype(::clock_nanosleep)>("clock_nanosleep");
+  struct timespec request {};
+  request.tv_sec = duration.count() / 1000000000;
+  request.tv_nsec = duration.count() % 1000000000;
+  // continue after interruptions by signal handlers
+  while(realClockNanosleep(CLOCK_MONOTONIC, 0, &request, &request) == EINTR) {
+  }
+}
+
+/**********************************************************************************************************************/
+
+bool DoocsServerTestHelper::virtualSleepUntil(int64_t wakeup) {
+  auto& clock = data.virtualClock;
+  if(!isServerThread || !clock.enabled) {
+    return false;
   }
-  if(data.sigusr1_lock.owns_lock()) {
-    data.sigusr1_lock.unlock();
+  std::unique_lock<std::mutex> lock(clock.mutex);
+  clock.cv.wait(lock, [&] { return clock.now >= wakeup || !clock.enabled; });
+  return true;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  _buckets[bucketIndex(std::max(int64_t(0), int64_t(duration.count())))].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**********************************************************************************************************************/
+
+uint64_t DoocsServerTestHelper::LatencyHistogram::count() const {
+  uint64_t n = 0;
+  for(const auto& bucket : _buckets) {
+    n += bucket.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+/**********************************************************************************************************************/
+
+std::chrono::nanoseconds DoocsServerTestHelper::LatencyHistogram::percentile(double p) const {
+  std::array<uint64_t, nBuckets> snapshot;
+  uint64_t n = 0;
+  for(size_t i = 0; i < nBuckets; ++i) {
+    snapshot[i] = _buckets[i].load(std::memory_order_relaxed);
+    n += snapshot[i];
+  }
+  if(n == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  auto threshold = std::max(uint64_t(1), uint64_t(std::ceil(p * double(n))));
+  uint64_t cumulated = 0;
+  size_t i = 0;
+  for(; i < nBuckets - 1; ++i) {
+    cumulated += snapshot[i];
+    if(cumulated >= threshold) {
+      break;
+    }
   }
+  return std::chrono::nanoseconds(bucketUpperBound(i));
 }
 
 /**********************************************************************************************************************/
 
-void DoocsServerTestHelper::doocsSetSpectrum(const std::string& name, const std::vector<float>& value) {
-  EqAdr ad;
+void DoocsServerTestHelper::LatencyHistogram::reset() {
+  for(auto& bucket : _buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+/**********************************************************************************************************************/
+
+size_t DoocsServerTestHelper::LatencyHistogram::bucketIndex(uint64_t ns) {
+  // values below 4 have their own bucket, above each power of two is split into 4 buckets
+  if(ns < 4) {
+    return ns;
+  }
+  auto msb = size_t(std::bit_width(ns) - 1);
+  auto sub = size_t((ns >> (msb - 2)) & 3);
+  return (msb - 1) * 4 + sub;
+}
+
+/**********************************************************************************************************************/
+
+uint64_t DoocsServerTestHelper::LatencyHistogram::bucketUpperBound(size_t index) {
+  if(index < 4) {
+    return index;
+  }
+  size_t msb = index / 4 + 1;
+  uint64_t sub = index % 4;
+  uint64_t lower = (4 + sub) << (msb - 2);
+  return lower + (uint64_t(1) << (msb - 2)) - 1;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::setRetryPolicy(const RetryPolicy& retryPolicy) {
+  data.retryPolicy.store(std::make_shared<const RetryPolicy>(retryPolicy), std::memory_order_release);
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::RetryPolicy DoocsServerTestHelper::getRetryPolicy() {
+  return *data.retryPolicy.load(std::memory_order_acquire);
+}
+
+/**********************************************************************************************************************/
+
+DoocsServerTestHelper::PropertyAddress DoocsServerTestHelper::resolveProperty(const std::string& name) {
+  PropertyAddress property;
+  property.name = name;
+  // obtain location pointer
+  property.adr.adr(name);
+  property.location = eq_get(&property.adr);
+  ASSERT(property.location != nullptr, std::string("Could not get location for property ") + name);
+  return property;
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::readArray(PropertyAddress& property, EqData& res, const RetryPolicy& retryPolicy) {
+  EqData ed;
+  prepareArrayRequest(ed);
+  // obtain values
+  accessWithRetry(property, res, retryPolicy, [&] { getArrayLocked(property.location, property.adr, ed, res); });
+  // check for errors
+  ASSERT(res.error() == 0, std::string("Error reading property ") + property.name + ": " + res.get_string());
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::prepareArrayRequest(EqData& ed) {
+  // for D_Spectrum: set IIII structure to obtain always the latest buffer
+  IIII iiii;
+  iiii.i1_data = -1;
+  iiii.i2_data = -1;
+  iiii.i3_data = -1;
+  iiii.i4_data = -1;
+  ed.set(&iiii);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::getArrayLocked(EqFct* location, EqAdr& adr, EqData& ed, EqData& res) {
+  // Try to get the data with parameters for a spectrum
+  location->get(&adr, &ed, &res);
+  if(res.error() == eq_errors::not_implemeted) {
+    // if that fails, assume we have a plain array, and just not pass the second parameter at all
+    location->get(&adr, nullptr, &res);
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsGetMany(ReadBatch& batch, const RetryPolicy& retryPolicy) {
+  // All locations are read before storing any value, so the targets are either all updated with the values of the
+  // final attempts or not at all. Entries after a failed one are not read in that attempt and hold outdated results.
+  for(auto& [location, entries] : batch._locations) {
+    const ReadBatch::Entry* failed = nullptr;
+    accessLocationWithRetry(location, retryPolicy, [&] {
+      failed = nullptr;
+      for(auto& entry : entries) {
+        if(entry.isArray) {
+          getArrayLocked(entry.property.location, entry.property.adr, *entry.ed, *entry.res);
+        }
+        else {
+          location->get(&entry.property.adr, entry.ed.get(), entry.res.get());
+        }
+        if(entry.res->error() != 0) {
+          failed = &entry;
+          return false;
+        }
+      }
+      return true;
+    });
+    ASSERT(failed == nullptr,
+        std::string("Error reading property ") + failed->property.name + ": " + failed->res->get_string());
+    if(failed != nullptr) {
+      return;
+    }
+  }
+  for(auto& [location, entries] : batch._locations) {
+    for(auto& entry : entries) {
+      entry.store(*entry.res);
+    }
+  }
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetMany(WriteBatch& batch, const RetryPolicy& retryPolicy) {
+  for(auto& [location, entries] : batch._locations) {
+    accessLocationWithRetry(location, retryPolicy, [&] {
+      for(auto& entry : entries) {
+        location->set(&entry.property.adr, entry.ed.get(), entry.res.get());
+        if(entry.res->error() != 0) {
+          return false;
+        }
+      }
+      return true;
+    });
+    for(auto& entry : entries) {
+      ASSERT(entry.res->error() == 0,
+          std::string("Error writing property ") + entry.property.name + ": " + entry.res->get_string());
+    }
+  }
+  notifyObservers();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetSpectrum(
+    const std::string& name, std::span<const float> value, const RetryPolicy& retryPolicy) {
   EqData ed, res;
   // fill spectrum data structure
   SPECTRUM spectrum;
@@ -188,30 +1311,56 @@ void DoocsServerTestHelper::doocsSetSpectrum(const std::string& name, const std:
   spectrum.s_inc = 1.;
   spectrum.status = 0;
   spectrum.d_spect_array.d_spect_array_len = value.size();
-  spectrum.d_spect_array.d_spect_array_val = (float*)value.data(); // casts const-ness away, but will not be modified
-                                                                   // (hopefully)
+  spectrum.d_spect_array.d_spect_array_val = const_cast<float*>(value.data()); // will not be modified (hopefully)
   ed.set(&spectrum);
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
   // set spectrum
-  size_t retry = 1000;
-  do {
-    p->lock();
-    p->set(&ad, &ed, &res);
-    p->unlock();
-    if(res.error() == 0) {
-      break;
-    }
-    usleep(10000);
-  } while(--retry > 0);
+  auto property = resolveProperty(name);
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->set(&property.adr, &ed, &res); });
   // check for error
   ASSERT(res.error() == 0, std::string("Error writing spectrum property ") + name);
+  notifyObservers();
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetSpectrum(
+    const std::string& name, const std::vector<float>& value, const RetryPolicy& retryPolicy) {
+  doocsSetSpectrum(name, std::span<const float>(value), retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetSpectrum(
+    const std::string& name, std::span<const double> value, const RetryPolicy& retryPolicy) {
+  // the conversion buffer is not kept, since spectra can be large
+  std::vector<float> buffer(value.begin(), value.end());
+  doocsSetSpectrum(name, std::span<const float>(buffer), retryPolicy);
+}
+
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetImage(
+    const std::string& name, const IMH& header, std::span<const uint8_t> value, const RetryPolicy& retryPolicy) {
+  EqData ed, res;
+  // fill image data structure
+  IMAGE image{};
+  image.hdr = header;
+  image.hdr.length = static_cast<int>(value.size());
+  image.val.val_len = value.size();
+  image.val.val_val = const_cast<u_char*>(value.data()); // will not be modified (hopefully)
+  ed.set(&image);
+  // set image
+  auto property = resolveProperty(name);
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->set(&property.adr, &ed, &res); });
+  // check for error
+  ASSERT(res.error() == 0, std::string("Error writing image property ") + name);
+  notifyObservers();
 }
 
-void DoocsServerTestHelper::doocsSetIIII(const std::string& name, const std::vector<int>& value) {
-  EqAdr ad;
+/**********************************************************************************************************************/
+
+void DoocsServerTestHelper::doocsSetIIII(
+    const std::string& name, const std::vector<int>& value, const RetryPolicy& retryPolicy) {
   EqData ed, res;
   ASSERT(value.size() == 4, std::string("Invalid input size, must be 4"));
 
@@ -223,48 +1372,10 @@ void DoocsServerTestHelper::doocsSetIIII(const std::string& name, const std::vec
   iiii.i4_data = value[3];
   ed.set(&iiii);
 
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
-  // set spectrum
-  size_t retry = 1000;
-  do {
-    p->lock();
-    p->set(&ad, &ed, &res);
-    p->unlock();
-    if(res.error() == 0) {
-      break;
-    }
-    usleep(10000);
-  } while(--retry > 0);
+  // set IIII
+  auto property = resolveProperty(name);
+  accessWithRetry(property, res, retryPolicy, [&] { property.location->set(&property.adr, &ed, &res); });
   // check for error
   ASSERT(res.error() == 0, std::string("Error writing IIII property ") + name);
-}
-
-/**********************************************************************************************************************/
-
-template<>
-std::string DoocsServerTestHelper::doocsGet<std::string>(const std::string& name) {
-  EqAdr ad;
-  EqData ed, res;
-  // obtain location pointer
-  ad.adr(name);
-  EqFct* p = eq_get(&ad);
-  ASSERT(p != nullptr, std::string("Could not get location for property ") + name);
-  // obtain value
-  size_t retry = 1000;
-  do {
-    p->lock();
-    p->get(&ad, &ed, &res);
-    p->unlock();
-    if(res.error() == 0) {
-      break;
-    }
-    usleep(10000);
-  } while(--retry > 0);
-  // check for errors
-  ASSERT(res.error() == 0, std::string("Error reading property ") + name);
-  // return requested type
-  return res.get_string();
+  notifyObservers();
 }
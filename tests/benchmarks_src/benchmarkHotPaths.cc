@@ -0,0 +1,195 @@
+/**
+ *  benchmarkHotPaths.cc
+ *
+ *  Benchmark for the hot paths of the DoocsServerTestHelper, run against a DOOCS server inside the process (see
+ *  testDoocsServerTestHelper_server.h) with LOC, OTHER and a number of further locations:
+ *  - the runUpdate()/runSigusr1() round trips through the DOOCS update and signal threads,
+ *  - the latency of doocsGet()/doocsSet() per type through EqFct::get()/EqFct::set(), compared with a PropertyHandle.
+ *    The properties of the last location are used, since the location lookup of the string-based API grows with the
+ *    number of locations,
+ *  - the throughput of doocsGetArray()/doocsSetSpectrum() versus the array size,
+ *  - the EqData conversions of the array accessors for sizes beyond the properties of the server.
+ *  Results are printed to stdout as one JSON object per line, e.g.
+ *
+ *    {"benchmark": "runUpdate", "size": 202, "iterations": 10000, "ns_per_iteration": 7512.3}
+ *
+ *  "size" is the number of locations resp. array elements. The optional first command line argument scales the number
+ *  of iterations (default 1.0), the second one sets the number of further locations (default 200). Like the tests, the
+ *  benchmark must be run from the directory containing the executable.
+ */
+
+#include "testDoocsServerTestHelper_access.h"
+#include "testDoocsServerTestHelper_server.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+static double iterationScale = 1.;
+
+// sink to prevent the compiler from optimising away the benchmarked code
+static volatile double sink;
+
+/** Run the function nIterations times and print the result */
+template<typename FUNCTION>
+static void measure(const std::string& benchmark, size_t size, size_t nIterations, FUNCTION function) {
+  nIterations = std::max(size_t(1), size_t(nIterations * iterationScale));
+  auto t0 = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < nIterations; ++i) {
+    function();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(nIterations);
+  std::cout << R"({"benchmark": ")" << benchmark << R"(", "size": )" << size << R"(, "iterations": )" << nIterations
+            << R"(, "ns_per_iteration": )" << ns << "}" << std::endl;
+}
+
+/**********************************************************************************************************************/
+
+static void benchmarkHandshake(size_t nLocations) {
+  // each cycle calls update() resp. interrupt_usr1() of all locations
+  measure("runUpdate", nLocations, 10000, [] { DoocsServerTestHelper::runUpdate(); });
+  measure("runSigusr1", nLocations, 10000, [] { DoocsServerTestHelper::runSigusr1(); });
+  measure("runUpdateBatched", nLocations, 10, [] { DoocsServerTestHelper::runUpdate(1000); });
+  measure("runUpdateAsync", nLocations, 10000, [] { DoocsServerTestHelper::runUpdateAsync().wait(); });
+}
+
+/**********************************************************************************************************************/
+
+static void benchmarkAddressResolution(size_t nLocations, const std::string& lastLocation) {
+  // cost saved on each access by a PropertyHandle, for the first and the last location
+  std::vector<std::pair<std::string, std::string>> properties{
+      {"first", "//LOC/INT"}, {"last", "//" + lastLocation + "/INT"}};
+  for(const auto& [which, name] : properties) {
+    measure("resolveAddress_" + which, nLocations, 1000000, [&] {
+      EqAdr ad;
+      ad.adr(name);
+      sink = (eq_get(&ad) != nullptr);
+    });
+  }
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+static void benchmarkScalar(size_t nLocations, const std::string& name, const std::string& typeName, TYPE value) {
+  auto handle = DoocsServerTestHelper::getPropertyHandle<TYPE>(name);
+  auto read = [](const TYPE& result) {
+    if constexpr(std::is_same<TYPE, std::string>()) {
+      sink = result.size();
+    }
+    else {
+      sink = result;
+    }
+  };
+
+  measure("doocsSet_" + typeName, nLocations, 100000, [&] { DoocsServerTestHelper::doocsSet<TYPE>(name, value); });
+  measure("handleSet_" + typeName, nLocations, 100000, [&] { handle.set(value); });
+  measure("doocsGet_" + typeName, nLocations, 100000, [&] { read(DoocsServerTestHelper::doocsGet<TYPE>(name)); });
+  measure("handleGet_" + typeName, nLocations, 100000, [&] { read(handle.get()); });
+}
+
+/**********************************************************************************************************************/
+
+static void benchmarkArrayAccess(const std::string& location) {
+  // array properties have a fixed size of 10 elements
+  std::vector<int> intArray(10, 1);
+  std::vector<int> intResult;
+  measure("doocsSet_intArray", intArray.size(), 100000,
+      [&] { DoocsServerTestHelper::doocsSet<int>(location + "/INT_ARRAY", intArray); });
+  measure("doocsGetArray_intArray", intArray.size(), 100000, [&] {
+    DoocsServerTestHelper::doocsGetArray<int>(location + "/INT_ARRAY", intResult);
+    sink = intResult.size();
+  });
+
+  // spectra accept any size up to their maximum
+  auto handle = DoocsServerTestHelper::getPropertyHandle<std::vector<float>>(location + "/SPECTRUM");
+  for(size_t size = 16; size <= 4096; size *= 16) {
+    std::vector<float> value(size, 1.F);
+    std::vector<float> result;
+    size_t nIterations = 10000000 / size;
+    measure("doocsSetSpectrum", size, nIterations,
+        [&] { DoocsServerTestHelper::doocsSetSpectrum(location + "/SPECTRUM", std::span<const float>(value)); });
+    measure("doocsGetArray_spectrum", size, nIterations, [&] {
+      DoocsServerTestHelper::doocsGetArray<float>(location + "/SPECTRUM", result);
+      sink = result.size();
+    });
+    measure("handleGet_spectrum", size, nIterations, [&] {
+      handle.get(result);
+      sink = result.size();
+    });
+  }
+}
+
+/**********************************************************************************************************************/
+
+template<typename TYPE>
+static void benchmarkArrayConversion(const std::string& typeName) {
+  for(size_t size = 16; size <= 65536; size *= 16) {
+    std::vector<TYPE> value(size, TYPE(1));
+    std::vector<TYPE> result;
+    EqData ed;
+    size_t nIterations = 10000000 / size;
+    measure("arrayToEqData_" + typeName, size, nIterations, [&] {
+      HelperAccess::toEqData(value, ed);
+      sink = ed.length();
+    });
+    measure("arrayFromEqData_" + typeName, size, nIterations, [&] {
+      HelperAccess::fromEqData(ed, result);
+      sink = result.size();
+    });
+  }
+}
+
+/**********************************************************************************************************************/
+
+int main(int argc, char* argv[]) {
+  if(argc > 1) {
+    iterationScale = std::atof(argv[1]);
+  }
+  size_t nExtraLocations = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 200;
+  size_t nLocations = nExtraLocations + 2;
+  std::string lastLocation = nExtraLocations > 0 ? "EXTRA" + std::to_string(nExtraLocations - 1) : "OTHER";
+
+  // only the executable name is passed on, the arguments are meant for the benchmark
+  auto server = startTestServer(1, argv, nExtraLocations);
+
+  benchmarkAddressResolution(nLocations, lastLocation);
+
+  auto property = "//" + lastLocation + "/";
+  benchmarkScalar<int>(nLocations, property + "INT", "int", 42);
+  benchmarkScalar<int64_t>(nLocations, property + "LONG", "int64", int64_t(1) << 40);
+  benchmarkScalar<float>(nLocations, property + "FLOAT", "float", 42.F);
+  benchmarkScalar<double>(nLocations, property + "DOUBLE", "double", 42.);
+  benchmarkScalar<std::string>(nLocations, property + "TEXT", "string", std::string("forty-two"));
+
+  benchmarkArrayAccess("//" + lastLocation);
+
+  benchmarkArrayConversion<int>("int");
+  benchmarkArrayConversion<short>("short");
+  benchmarkArrayConversion<int64_t>("int64");
+  benchmarkArrayConversion<float>("float");
+  benchmarkArrayConversion<double>("double");
+
+  benchmarkHandshake(nLocations);
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
@@ -0,0 +1,63 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_access.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+using namespace boost::unit_test_framework;
+
+// read the array into a buffer which is shorter than the array and followed by a canary element
+template<typename TYPE>
+void checkShortBuffer(EqData& ed, const std::vector<TYPE>& expected) {
+  const TYPE canary = TYPE(-42);
+  std::vector<TYPE> buffer(4, TYPE(0));
+  buffer[3] = canary;
+  auto length = HelperAccess::fromEqData(ed, std::span<TYPE>(buffer.data(), 3));
+  BOOST_CHECK_EQUAL(length, size_t(ed.length()));
+  for(size_t i = 0; i < 3; ++i) {
+    BOOST_CHECK_EQUAL(buffer[i], expected[i]);
+  }
+  BOOST_CHECK_EQUAL(buffer[3], canary);
+}
+
+BOOST_AUTO_TEST_CASE(TestArrayBuffer) {
+  EqData ed;
+  HelperAccess::toEqData(std::vector<int>{1, 2, 3, 4, 5, 6}, ed);
+  BOOST_CHECK_EQUAL(ed.type(), DATA_A_INT);
+
+  // bulk copy when the element type matches
+  checkShortBuffer<int>(ed, {1, 2, 3});
+
+  // conversion of each element otherwise
+  checkShortBuffer<double>(ed, {1., 2., 3.});
+  checkShortBuffer<long long>(ed, {1, 2, 3});
+
+  // 64 bit arrays
+  EqData edLong;
+  HelperAccess::toEqData(std::vector<long long>{(1LL << 40) + 1, 2, 3, 4, 5}, edLong);
+  checkShortBuffer<long long>(edLong, {(1LL << 40) + 1, 2, 3});
+  checkShortBuffer<long>(edLong, {(1L << 40) + 1, 2, 3});
+  checkShortBuffer<double>(edLong, {double((1LL << 40) + 1), 2., 3.});
+
+  // a buffer large enough for the whole array is filled with all elements, the rest is left alone
+  std::vector<float> buffer(8, -1.F);
+  EqData edFloat;
+  HelperAccess::toEqData(std::vector<float>{0.5F, 1.5F}, edFloat);
+  BOOST_CHECK_EQUAL(HelperAccess::fromEqData(edFloat, std::span<float>(buffer)), size_t(2));
+  BOOST_CHECK((buffer == std::vector<float>{0.5F, 1.5F, -1.F, -1.F, -1.F, -1.F, -1.F, -1.F}));
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_access.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <climits>
+
+using namespace boost::unit_test_framework;
+
+// the DOOCS type is chosen at compile time
+static_assert(detail::doocsArrayType<bool>() == DATA_A_BOOL);
+static_assert(detail::doocsArrayType<int8_t>() == DATA_A_SHORT);
+static_assert(detail::doocsArrayType<uint8_t>() == DATA_A_BYTE);
+static_assert(detail::doocsArrayType<unsigned short>() == DATA_A_INT);
+static_assert(detail::doocsArrayType<unsigned int>() == DATA_A_LONG);
+static_assert(detail::doocsArrayType<long>() == DATA_A_LONG);
+static_assert(detail::doocsArrayType<long long>() == DATA_A_LONG);
+static_assert(detail::doocsArrayType<float>() == DATA_A_FLOAT);
+static_assert(detail::doocsArrayType<double>() == DATA_A_DOUBLE);
+
+// write the values into an EqData, check the type and read them back
+template<typename TYPE>
+void checkRoundTrip(const std::vector<TYPE>& value, int expectedType) {
+  EqData ed;
+  HelperAccess::toEqData(value, ed);
+  BOOST_CHECK_EQUAL(ed.type(), expectedType);
+  BOOST_CHECK_EQUAL(ed.length(), int(value.size()));
+  std::vector<TYPE> result;
+  HelperAccess::fromEqData(ed, result);
+  BOOST_CHECK(result == value);
+}
+
+BOOST_AUTO_TEST_CASE(TestArrayConversion) {
+  checkRoundTrip<bool>({true, false, true}, DATA_A_BOOL);
+  checkRoundTrip<uint8_t>({0, 1, 200, 255}, DATA_A_BYTE);
+  checkRoundTrip<unsigned short>({0, 1, 65535}, DATA_A_INT);
+  checkRoundTrip<float>({-1.5F, 0.F, 3.25F}, DATA_A_FLOAT);
+  checkRoundTrip<double>({-0.1, 0., 1e300}, DATA_A_DOUBLE);
+
+  // signed bytes are written as shorts, since DOOCS bytes are unsigned
+  checkRoundTrip<int8_t>({-128, -1, 0, 127}, DATA_A_SHORT);
+  EqData ed;
+  HelperAccess::toEqData(std::vector<int8_t>{-1, -128}, ed);
+  BOOST_CHECK_EQUAL(ed.get_int(0), -1);
+  BOOST_CHECK_EQUAL(ed.get_int(1), -128);
+
+  // unsigned ints above INT_MAX are written as longs without loss
+  unsigned int large = static_cast<unsigned int>(INT_MAX) + 10;
+  checkRoundTrip<unsigned int>({0, large, UINT_MAX}, DATA_A_LONG);
+  HelperAccess::toEqData(std::vector<unsigned int>{large, UINT_MAX}, ed);
+  BOOST_CHECK_EQUAL(ed.get_long(0), static_cast<long long>(large));
+  BOOST_CHECK_EQUAL(ed.get_long(1), static_cast<long long>(UINT_MAX));
+
+  // long and long long are both copied in bulk, since they have the same representation
+  checkRoundTrip<long>({LONG_MIN, -1, 0, (1L << 40) + 1, LONG_MAX}, DATA_A_LONG);
+  checkRoundTrip<long long>({LLONG_MIN, -1, 0, (1LL << 40) + 1, LLONG_MAX}, DATA_A_LONG);
+  HelperAccess::toEqData(std::vector<long>{(1L << 40) + 1, -2}, ed);
+  BOOST_CHECK_EQUAL(ed.get_long(0), (1LL << 40) + 1);
+  BOOST_CHECK_EQUAL(ed.get_long(1), -2);
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
@@ -0,0 +1,65 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+using namespace boost::unit_test_framework;
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // test an asynchronous update cycle: the future must only become ready once the cycle is complete
+  std::cout << "DoocsServerTestHelper::runUpdateAsync() ->" << std::endl;
+  auto f1 = DoocsServerTestHelper::runUpdateAsync();
+  std::cout << "<- DoocsServerTestHelper::runUpdateAsync()" << std::endl;
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  allowUpdate();
+  BOOST_CHECK(f1.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  waitUpdate();
+
+  // test an asynchronous sigusr1 cycle
+  std::cout << "DoocsServerTestHelper::runSigusr1Async() ->" << std::endl;
+  auto f2 = DoocsServerTestHelper::runSigusr1Async();
+  std::cout << "<- DoocsServerTestHelper::runSigusr1Async()" << std::endl;
+  BOOST_CHECK(f2.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  allowSigusr1();
+  BOOST_CHECK(f2.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  waitSigusr1();
+
+  // test an asynchronous batch of two update cycles followed by a synchronous cycle, which has to wait for the batch
+  std::atomic<bool> flag{false};
+  size_t nCallbacks = 0;
+  auto f3 = DoocsServerTestHelper::runUpdateAsync(2, [&](size_t) { ++nCallbacks; });
+  std::thread t1([&] {
+    for(size_t i = 0; i < 3; ++i) {
+      usleep(100000);
+      BOOST_CHECK(flag == false);
+      allowUpdate();
+    }
+  });
+  std::cout << "DoocsServerTestHelper::runUpdate() ->" << std::endl;
+  DoocsServerTestHelper::runUpdate();
+  std::cout << "<- DoocsServerTestHelper::runUpdate()" << std::endl;
+  flag = true;
+  t1.join();
+  BOOST_CHECK(f3.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(nCallbacks, 2);
+  for(size_t i = 0; i < 3; ++i) {
+    waitUpdate();
+  }
+
+  // a pending cycle is released by shutdown()
+  f1 = DoocsServerTestHelper::runUpdateAsync();
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  extern int build_phase;
+  build_phase = 0; // prevent eq_exit() called inside shutdown() to just terminate the process...
+  DoocsServerTestHelper::shutdown();
+  BOOST_CHECK(f1.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+}
+
+BOOST_AUTO_TEST_CASE(TestAsyncStepping) {
+  HelperTest test;
+  test.testRoutine();
+}
@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+using namespace boost::unit_test_framework;
+
+#define CHECK_TIMEOUT(condition, maxMilliseconds)                                                                      \
+  {                                                                                                                    \
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();                                       \
+    while(!(condition)) {                                                                                              \
+      bool timeout_reached = (std::chrono::steady_clock::now() - t0) > std::chrono::milliseconds(maxMilliseconds);     \
+      BOOST_CHECK(!timeout_reached);                                                                                   \
+      if(timeout_reached) break;                                                                                       \
+      usleep(1000);                                                                                                    \
+    }                                                                                                                  \
+  }
+
+void HelperTest::testRoutineBody() {
+  std::atomic<bool> flag{};
+  std::vector<size_t> cycles;
+
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // test a batch of three update cycles: runUpdate() must only return after the third cycle is complete
+  flag = false;
+  std::thread t1([&] {
+    for(size_t i = 0; i < 3; ++i) {
+      usleep(100000);
+      BOOST_CHECK(flag == false);
+      allowUpdate();
+    }
+    CHECK_TIMEOUT(flag == true, 5000);
+  });
+  std::cout << "DoocsServerTestHelper::runUpdate(3) ->" << std::endl;
+  DoocsServerTestHelper::runUpdate(3, [&](size_t cycle) { cycles.push_back(cycle); });
+  std::cout << "<- DoocsServerTestHelper::runUpdate(3)" << std::endl;
+  flag = true;
+  t1.join();
+  for(size_t i = 0; i < 3; ++i) {
+    waitUpdate();
+  }
+  BOOST_CHECK((cycles == std::vector<size_t>{0, 1, 2}));
+
+  // test a batch of two sigusr1 cycles
+  cycles.clear();
+  flag = false;
+  std::thread t2([&] {
+    for(size_t i = 0; i < 2; ++i) {
+      usleep(100000);
+      BOOST_CHECK(flag == false);
+      allowSigusr1();
+    }
+    CHECK_TIMEOUT(flag == true, 5000);
+  });
+  std::cout << "DoocsServerTestHelper::runSigusr1(2) ->" << std::endl;
+  DoocsServerTestHelper::runSigusr1(2, [&](size_t cycle) { cycles.push_back(cycle); });
+  std::cout << "<- DoocsServerTestHelper::runSigusr1(2)" << std::endl;
+  flag = true;
+  t2.join();
+  for(size_t i = 0; i < 2; ++i) {
+    waitSigusr1();
+  }
+  BOOST_CHECK((cycles == std::vector<size_t>{0, 1}));
+
+  // a single cycle without callback still works as before
+  flag = false;
+  std::thread t3([&] {
+    usleep(100000);
+    BOOST_CHECK(flag == false);
+    allowUpdate();
+    CHECK_TIMEOUT(flag == true, 5000);
+  });
+  std::cout << "DoocsServerTestHelper::runUpdate(1) ->" << std::endl;
+  DoocsServerTestHelper::runUpdate(1);
+  std::cout << "<- DoocsServerTestHelper::runUpdate(1)" << std::endl;
+  flag = true;
+  t3.join();
+  waitUpdate();
+}
+
+BOOST_AUTO_TEST_CASE(TestBatchedStepping) {
+  HelperTest test;
+  test.testRoutine();
+}
@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE testConfigOverrides
+
+#include "ThreadedDoocsServer.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <sstream>
+
+using namespace boost::unit_test_framework;
+
+// gives access to the name of the instance config file
+struct ConfigOverridesTest : public ThreadedDoocsServer {
+  using ThreadedDoocsServer::ThreadedDoocsServer;
+  using ThreadedDoocsServer::_configFileInstance;
+};
+
+/**********************************************************************************************************************/
+
+static std::string readFile(const std::string& path) {
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestConfigOverrides) {
+  auto lockDirectory =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("testConfigOverrides-%%%%-%%%%");
+  boost::filesystem::create_directories(lockDirectory);
+  ThreadedDoocsServer::setLockDirectory(lockDirectory.string());
+
+  const std::string config = "eq_conf:\n"
+                             "\n"
+                             "eq_fct_name: \"TEST._SVR\"\n"
+                             "eq_fct_type: 1\n"
+                             "{\n"
+                             "SVR.RPC_NUMBER: 610500000\n"
+                             "SVR.BPN: 600\n"
+                             "SVR.TIMEOUT: 1000\n"
+                             "}\n"
+                             "eq_fct_name: \"LOC\"\n"
+                             "eq_fct_type: 10\n"
+                             "{\n"
+                             "VALUE: 1\n"
+                             "VALUE.DESC: \"VALUE: 1\"\n"
+                             "# VALUE: 2\n"
+                             "OTHER: 3\n"
+                             "}";
+  std::ofstream("testConfigOverrides.conf") << config;
+
+  char arg0[] = "testConfigOverrides";
+  char* argv[] = {arg0};
+  {
+    ConfigOverridesTest server("testConfigOverrides.conf", 1, argv, std::make_unique<doocs::Server>("test"), false,
+        {{"SVR.TIMEOUT", "42"}, {"VALUE", "\"some text\""}, {"NOT_IN_CONFIG", "1"}});
+
+    // the RPC number and BPN are always replaced, the other overrides only where the key matches the whole line prefix
+    auto expected = config;
+    auto replace = [&](const std::string& from, const std::string& to) {
+      auto pos = expected.find(from);
+      BOOST_REQUIRE(pos != std::string::npos);
+      expected.replace(pos, from.size(), to);
+    };
+    replace("SVR.RPC_NUMBER: 610500000", "SVR.RPC_NUMBER: " + server.rpcNo());
+    replace("SVR.BPN: 600", "SVR.BPN: " + server.bpn());
+    replace("SVR.TIMEOUT: 1000", "SVR.TIMEOUT: 42");
+    replace("VALUE: 1\n", "VALUE: \"some text\"\n");
+    BOOST_CHECK_EQUAL(readFile(server._configFileInstance), expected + "\n");
+    BOOST_CHECK(expected.find("NOT_IN_CONFIG") == std::string::npos);
+
+    // the original config file is not modified
+    BOOST_CHECK_EQUAL(readFile("testConfigOverrides.conf"), config);
+  }
+
+  boost::filesystem::remove("testConfigOverrides.conf");
+  boost::filesystem::remove_all(lockDirectory);
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
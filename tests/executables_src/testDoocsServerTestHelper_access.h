@@ -0,0 +1,37 @@
+/**
+ *  testDoocsServerTestHelper_access.h
+ *
+ *  Access to the protected conversion functions and snapshot internals of the DoocsServerTestHelper, so they can be
+ *  tested and benchmarked without a DOOCS server.
+ */
+
+#pragma once
+
+#include "doocsServerTestHelper.h"
+
+struct HelperAccess : DoocsServerTestHelper {
+  using DoocsServerTestHelper::fromEqData;
+  using DoocsServerTestHelper::toEqData;
+};
+
+/** Snapshot filled from given EqData values instead of reading properties */
+struct SnapshotAccess : DoocsServerTestHelper::Snapshot {
+  using Snapshot::Layout;
+  using Snapshot::serialise;
+
+  SnapshotAccess(std::shared_ptr<const Layout> layout, const std::vector<EqData*>& values)
+  : Snapshot(std::move(layout)) {
+    for(auto* value : values) {
+      _offsets.push_back(_buffer.size());
+      serialise(*value, _buffer);
+    }
+    _offsets.push_back(_buffer.size());
+  }
+
+  /** layout with the given property names, without locations and addresses */
+  static std::shared_ptr<const Layout> makeLayout(const std::vector<std::string>& names) {
+    auto layout = std::make_shared<Layout>();
+    layout->names = names;
+    return layout;
+  }
+};
@@ -0,0 +1,95 @@
+/**
+ *  testDoocsServerTestHelper_server.h
+ *
+ *  DOOCS server running inside the test process, for tests and benchmarks which access real properties through the
+ *  DoocsServerTestHelper. The server has the locations LOC and OTHER of the class TestLocation, optionally followed by
+ *  further locations EXTRA0, EXTRA1, ...
+ *
+ *  The ThreadedDoocsServer runs the instance through a symlink to the executable, so the config file is written to the
+ *  working directory and named like the executable.
+ */
+
+#pragma once
+
+#include "ThreadedDoocsServer.h"
+
+#include <eq_fct.h>
+
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+
+/** Location with one property of each type supported by the helper. update() counts its calls. */
+class TestLocation : public EqFct {
+ public:
+  static constexpr int code = 10;
+
+  explicit TestLocation(const EqFctParameters& p) : EqFct(p) {}
+
+  D_int intValue{"INT", this};
+  D_long longValue{"LONG", this};
+  D_float floatValue{"FLOAT", this};
+  D_double doubleValue{"DOUBLE", this};
+  D_string textValue{"TEXT", this};
+  D_intarray intArray{"INT_ARRAY", 10, this};
+  D_doublearray doubleArray{"DOUBLE_ARRAY", 10, this};
+  D_spectrum spectrum{"SPECTRUM", 4096, this};
+  D_imagec image{"IMAGE", this};
+
+  /** number of update() calls and the wall clock time (seconds) seen by the last one */
+  D_int updates{"UPDATES", this};
+  D_long lastUpdateTime{"LAST_UPDATE_TIME", this};
+
+  int fct_code() override { return code; }
+
+  void update() override {
+    updates.set_value(updates.value() + 1);
+    lastUpdateTime.set_value(time(nullptr));
+  }
+};
+
+/**********************************************************************************************************************/
+
+/** Config of the test server. The RPC number and BPN are replaced by the ThreadedDoocsServer. */
+const std::string testServerConfig = "eq_conf:\n"
+                                     "\n"
+                                     "eq_fct_name: \"TEST._SVR\"\n"
+                                     "eq_fct_type: 1\n"
+                                     "{\n"
+                                     "SVR.RPC_NUMBER: 610500000\n"
+                                     "SVR.BPN: 600\n"
+                                     "}\n"
+                                     "eq_fct_name: \"LOC\"\n"
+                                     "eq_fct_type: 10\n"
+                                     "{\n"
+                                     "INT: 42\n"
+                                     "LONG: 1099511627776\n"
+                                     "DOUBLE: 1.5\n"
+                                     "TEXT: \"initial text\"\n"
+                                     "}\n"
+                                     "eq_fct_name: \"OTHER\"\n"
+                                     "eq_fct_type: 10\n"
+                                     "{\n"
+                                     "INT: 7\n"
+                                     "}\n";
+
+/** Write the config for the executable argv[0] and start the server. Returns after the locations are initialised. */
+inline std::unique_ptr<ThreadedDoocsServer> startTestServer(int argc, char* argv[], size_t nExtraLocations = 0) {
+  std::string serverName = boost::filesystem::path(argv[0]).filename().string();
+  std::ofstream config(serverName + ".conf");
+  config << testServerConfig;
+  for(size_t i = 0; i < nExtraLocations; ++i) {
+    config << "eq_fct_name: \"EXTRA" << i << "\"\neq_fct_type: 10\n{\nINT: 0\n}\n";
+  }
+  config.close();
+
+  auto doocsServer = std::make_unique<doocs::Server>(serverName);
+  doocsServer->register_location_class(
+      TestLocation::code, [](const EqFctParameters& p) { return std::make_unique<TestLocation>(p); });
+  auto server = std::make_unique<ThreadedDoocsServer>(serverName + ".conf", argc, argv, std::move(doocsServer));
+
+  // the update thread only starts waiting for updates after all locations have been initialised
+  DoocsServerTestHelper::runUpdate();
+  return server;
+}
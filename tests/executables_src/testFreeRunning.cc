@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+using namespace boost::unit_test_framework;
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // use a second server with a simulated update thread which is not controlled by the HelperTest
+  doocs::Server server("secondServer");
+  DoocsServerTestHelper::initialise(&server);
+  auto& second = DoocsServerTestHelper::getInstance(&server);
+  std::atomic<uint64_t> nUpdates{0};
+  std::atomic<bool> terminate{false};
+  std::thread threadSecondUpdate([&] {
+    while(!terminate) {
+      DoocsServerTestHelper::waitForUpdate(&server);
+      ++nUpdates;
+    }
+  });
+  second.runUpdate();
+  BOOST_CHECK_EQUAL(nUpdates, 1);
+
+  // free-running: update cycles run without being triggered
+  second.startFreeRunning();
+  usleep(100000);
+  second.stopFreeRunning();
+  auto statistics = second.getFreeRunningStatistics();
+  std::cout << "free-running: " << statistics.cycles << " cycles, " << statistics.cyclesPerSecond() << " cycles/s"
+            << std::endl;
+  BOOST_CHECK(statistics.cycles > 100);
+  BOOST_CHECK(statistics.duration >= std::chrono::milliseconds(100));
+  BOOST_CHECK_EQUAL(nUpdates, 1 + statistics.cycles);
+
+  // after stopping, the update thread is back in lock-step mode
+  usleep(100000);
+  BOOST_CHECK_EQUAL(nUpdates, 1 + statistics.cycles);
+  second.runUpdate(2);
+  BOOST_CHECK_EQUAL(nUpdates, 3 + statistics.cycles);
+
+  // paced free-running mode with a period of 10 ms
+  nUpdates = 0;
+  second.startFreeRunning(std::chrono::milliseconds(10));
+  usleep(205000);
+  second.stopFreeRunning();
+  statistics = second.getFreeRunningStatistics();
+  BOOST_CHECK_EQUAL(nUpdates, statistics.cycles);
+  BOOST_CHECK(statistics.cycles >= 10);
+  BOOST_CHECK(statistics.cycles <= 21);
+
+  // runUpdate() waits until free-running is stopped
+  second.startFreeRunning();
+  auto f1 = std::async(std::launch::async, [&] { second.runUpdate(); });
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  second.stopFreeRunning();
+  BOOST_CHECK(f1.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+  // reset() stops free-running, so a test case leaving it enabled does not block the next one
+  second.startFreeRunning();
+  second.reset();
+  auto cycles = second.getFreeRunningStatistics().cycles;
+  usleep(10000);
+  BOOST_CHECK_EQUAL(second.getFreeRunningStatistics().cycles, cycles);
+  second.startFreeRunning();
+  DoocsServerTestHelper::reset();
+  cycles = second.getFreeRunningStatistics().cycles;
+  usleep(10000);
+  BOOST_CHECK_EQUAL(second.getFreeRunningStatistics().cycles, cycles);
+  nUpdates = 0;
+  second.runUpdate();
+  BOOST_CHECK_EQUAL(nUpdates, 1);
+
+  // runUpdateFor() cannot be used while free-running, since update() would run concurrently
+  DoocsServerTestHelper::startFreeRunning();
+  waitUpdate(); // the update thread of the HelperTest has completed one free-running cycle
+  BOOST_CHECK_THROW(DoocsServerTestHelper::runUpdateFor(std::vector<EqFct*>{}), std::logic_error);
+  std::thread t1([&] {
+    usleep(100000);
+    allowUpdate();
+  });
+  DoocsServerTestHelper::reset();
+  t1.join();
+  BOOST_CHECK_NO_THROW(DoocsServerTestHelper::runUpdateFor(std::vector<EqFct*>{}));
+
+  terminate = true;
+  second.release();
+  threadSecondUpdate.join();
+}
+
+BOOST_AUTO_TEST_CASE(TestFreeRunning) {
+  HelperTest test;
+  test.testRoutine();
+}
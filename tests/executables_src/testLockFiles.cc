@@ -0,0 +1,140 @@
+#define BOOST_TEST_MODULE testLockFiles
+
+#include "ThreadedDoocsServer.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace boost::unit_test_framework;
+
+// gives access to the lock file implementation of the ThreadedDoocsServer
+struct LockFileTest : public ThreadedDoocsServer {
+  using ThreadedDoocsServer::claimNumber;
+  using ThreadedDoocsServer::LockFile;
+};
+
+/**********************************************************************************************************************/
+
+// use a private lock directory, so the test does not interfere with concurrently running tests
+struct LockDirectoryFixture {
+  LockDirectoryFixture() {
+    directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("testLockFiles-%%%%-%%%%");
+    boost::filesystem::create_directories(directory);
+    ThreadedDoocsServer::setLockDirectory(directory.string());
+  }
+  ~LockDirectoryFixture() { boost::filesystem::remove_all(directory); }
+
+  boost::filesystem::path directory;
+};
+
+/**********************************************************************************************************************/
+
+BOOST_FIXTURE_TEST_CASE(TestLockFile, LockDirectoryFixture) {
+  BOOST_CHECK_EQUAL(ThreadedDoocsServer::getLockDirectory(), directory.string());
+  auto path = (directory / "test.lock").string();
+
+  // a locked file cannot be locked a second time, even from the same process
+  LockFileTest::LockFile a, b;
+  BOOST_CHECK(a.tryLock(path));
+  BOOST_CHECK(boost::filesystem::exists(path));
+  BOOST_CHECK(!b.tryLock(path));
+
+  // releasing removes the file and lets the next one lock it
+  a.release();
+  BOOST_CHECK(!boost::filesystem::exists(path));
+  BOOST_CHECK(b.tryLock(path));
+  b.release();
+
+  // a left-over file without lock (e.g. from a crashed process) can be locked
+  std::ofstream(path).close();
+  BOOST_CHECK(a.tryLock(path));
+
+  // the destructor releases the lock
+  {
+    LockFileTest::LockFile c;
+    a.release();
+    BOOST_CHECK(c.tryLock(path));
+  }
+  BOOST_CHECK(!boost::filesystem::exists(path));
+
+  // a file in a non-existing directory cannot be locked
+  BOOST_CHECK(!a.tryLock((directory / "missing" / "test.lock").string()));
+}
+
+/**********************************************************************************************************************/
+
+BOOST_FIXTURE_TEST_CASE(TestLockFileConcurrency, LockDirectoryFixture) {
+  // Each thread repeatedly locks and releases the same file. Releasing removes the file while another thread may have
+  // just opened it, which must not result in two threads holding the lock at the same time.
+  auto path = (directory / "test.lock").string();
+  std::atomic<int> holders{0};
+  std::atomic<size_t> violations{0}, locked{0};
+  std::vector<std::thread> threads;
+  for(size_t t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      LockFileTest::LockFile lock;
+      for(size_t i = 0; i < 2000; ++i) {
+        if(!lock.tryLock(path)) {
+          continue;
+        }
+        ++locked;
+        if(++holders != 1) {
+          ++violations;
+        }
+        // hold the lock for a moment, so an overlap would be detected
+        std::this_thread::yield();
+        if(holders != 1) {
+          ++violations;
+        }
+        --holders;
+        lock.release();
+      }
+    });
+  }
+  for(auto& thread : threads) {
+    thread.join();
+  }
+  BOOST_CHECK_EQUAL(violations, 0);
+  BOOST_CHECK(locked > 0);
+}
+
+/**********************************************************************************************************************/
+
+BOOST_FIXTURE_TEST_CASE(TestClaimNumber, LockDirectoryFixture) {
+  // claimed numbers are distinct and multiplied by the factor
+  std::uniform_int_distribution<int> distribution(1, 3);
+  LockFileTest::LockFile locks[4];
+  std::vector<std::string> claimed;
+  for(size_t i = 0; i < 3; ++i) {
+    claimed.push_back(LockFileTest::claimNumber("test_", distribution, 10, locks[i]));
+  }
+  BOOST_CHECK((std::set<std::string>(claimed.begin(), claimed.end()) == std::set<std::string>{"10", "20", "30"}));
+  BOOST_CHECK(boost::filesystem::exists(directory / ("test_" + claimed[1] + ".lock")));
+
+  // all numbers are taken
+  BOOST_CHECK_THROW(LockFileTest::claimNumber("test_", distribution, 10, locks[3]), std::runtime_error);
+
+  // a released number can be claimed again, other prefixes are independent
+  locks[1].release();
+  BOOST_CHECK_EQUAL(LockFileTest::claimNumber("test_", distribution, 10, locks[3]), claimed[1]);
+  LockFileTest::LockFile other;
+  BOOST_CHECK_NO_THROW(LockFileTest::claimNumber("other_", distribution, 1, other));
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
@@ -0,0 +1,105 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+using namespace boost::unit_test_framework;
+
+// third server, which is retired during the test and only released by the shutdown
+std::unique_ptr<doocs::Server> thirdServer;
+std::thread threadThirdUpdate;
+std::atomic<size_t> nThirdUpdates{0};
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // register a second server, which gets its own instance
+  doocs::Server server("secondServer");
+  DoocsServerTestHelper::initialise(&server);
+  auto& second = DoocsServerTestHelper::getInstance(&server);
+  BOOST_CHECK(&second != &DoocsServerTestHelper::getInstance(nullptr));
+  BOOST_CHECK(second.getServer() == &server);
+
+  // simulate the update thread of the second server
+  std::atomic<size_t> nUpdates{0};
+  std::atomic<bool> terminate{false};
+  std::thread threadSecondUpdate([&] {
+    while(!terminate) {
+      DoocsServerTestHelper::waitForUpdate(&server);
+      ++nUpdates;
+    }
+  });
+
+  // update cycles of the second server do not need the update thread of the default instance
+  std::cout << "second.runUpdate(3) ->" << std::endl;
+  second.runUpdate(3);
+  std::cout << "<- second.runUpdate(3)" << std::endl;
+  BOOST_CHECK_EQUAL(nUpdates, 3);
+  BOOST_CHECK_EQUAL(second.getUpdateStatistics().processing.count(), 3);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::getUpdateStatistics().processing.count(), 0);
+
+  // update cycles of the default instance do not trigger the second server
+  auto f1 = DoocsServerTestHelper::runUpdateAsync();
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  allowUpdate();
+  BOOST_CHECK(f1.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  waitUpdate();
+  BOOST_CHECK_EQUAL(nUpdates, 3);
+
+  // signals are process-wide, so only the default instance can run sigusr1 cycles
+  BOOST_CHECK_THROW(second.runSigusr1(), std::logic_error);
+
+  // a retired instance keeps its update thread blocked, so it neither loops nor advances the virtual clock
+  thirdServer = std::make_unique<doocs::Server>("thirdServer");
+  DoocsServerTestHelper::initialise(thirdServer.get());
+  auto& third = DoocsServerTestHelper::getInstance(thirdServer.get());
+  threadThirdUpdate = std::thread([] {
+    while(true) {
+      DoocsServerTestHelper::waitForUpdate(thirdServer.get());
+      if(flagTerminate) {
+        break;
+      }
+      ++nThirdUpdates;
+    }
+  });
+  third.runUpdate(2);
+  BOOST_CHECK_EQUAL(nThirdUpdates, 2);
+  DoocsServerTestHelper::enableVirtualClock(std::chrono::seconds(1), std::chrono::system_clock::from_time_t(1000));
+  third.retire();
+  usleep(100000);
+  BOOST_CHECK_EQUAL(nThirdUpdates, 2);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == std::chrono::system_clock::from_time_t(1000));
+  BOOST_CHECK_THROW(third.runUpdate(), std::logic_error);
+  BOOST_CHECK_THROW(third.startFreeRunning(), std::logic_error);
+
+  // the remaining server and the virtual clock only move on runUpdate()
+  size_t nUpdatesBefore = nUpdates;
+  usleep(100000);
+  BOOST_CHECK_EQUAL(nUpdates, nUpdatesBefore);
+  second.runUpdate(2);
+  BOOST_CHECK_EQUAL(nUpdates, nUpdatesBefore + 2);
+  BOOST_CHECK_EQUAL(nThirdUpdates, 2);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == std::chrono::system_clock::from_time_t(1002));
+  DoocsServerTestHelper::disableVirtualClock();
+
+  // releasing the second instance does not affect the default instance
+  terminate = true;
+  second.release();
+  threadSecondUpdate.join();
+  auto f2 = DoocsServerTestHelper::runUpdateAsync();
+  BOOST_CHECK(f2.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  allowUpdate();
+  BOOST_CHECK(f2.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  waitUpdate();
+}
+
+BOOST_AUTO_TEST_CASE(TestMultipleInstances) {
+  HelperTest test;
+  test.testRoutine();
+
+  // the retired instance has been released by the shutdown without running further cycles
+  threadThirdUpdate.join();
+  BOOST_CHECK_EQUAL(nThirdUpdates, 2);
+}
@@ -0,0 +1,322 @@
+#define BOOST_TEST_MODULE testPropertyAccess
+
+#include "DoocsScenario.h"
+#include "testDoocsServerTestHelper_server.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <unistd.h>
+
+#include <array>
+#include <cmath>
+#include <thread>
+
+using namespace boost::unit_test_framework;
+
+// server shared by all test cases, each test case starts with ThreadedDoocsServer::reset()
+std::unique_ptr<ThreadedDoocsServer> server;
+
+struct ServerFixture {
+  ServerFixture() {
+    auto& suite = framework::master_test_suite();
+    server = startTestServer(suite.argc, suite.argv);
+  }
+  ~ServerFixture() { server.reset(); }
+};
+BOOST_GLOBAL_FIXTURE(ServerFixture);
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestResetToConfigValues) {
+  server->reset();
+
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT", 123);
+  DoocsServerTestHelper::doocsSet<int64_t>("//LOC/LONG", -5);
+  DoocsServerTestHelper::doocsSet<double>("//LOC/DOUBLE", 9.5);
+  DoocsServerTestHelper::doocsSet<std::string>("//LOC/TEXT", "changed");
+  DoocsServerTestHelper::doocsSet<int>("//OTHER/INT", 8);
+  DoocsServerTestHelper::doocsSet<float>("//LOC/FLOAT", 2.5F);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//LOC/INT"), 123);
+
+  // the values from the config file are written back
+  server->reset();
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//LOC/INT"), 42);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int64_t>("//LOC/LONG"), 1LL << 40);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<double>("//LOC/DOUBLE"), 1.5);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<std::string>("//LOC/TEXT"), "initial text");
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//OTHER/INT"), 7);
+
+  // properties without a value in the config file keep their current value
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<float>("//LOC/FLOAT"), 2.5F);
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestBatches) {
+  server->reset();
+
+  // write properties of both locations, including arrays, in one batch
+  DoocsServerTestHelper::WriteBatch write;
+  write.add<int>("//LOC/INT", -3);
+  write.add<int64_t>("//LOC/LONG", (1LL << 40) + 3);
+  write.add<double>("//LOC/DOUBLE", 0.25);
+  write.add<std::string>("//LOC/TEXT", "batch");
+  write.add<std::vector<int>>("//LOC/INT_ARRAY", {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  write.add<std::vector<double>>("//OTHER/DOUBLE_ARRAY", {0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5});
+  write.add<int>("//OTHER/INT", 77);
+  DoocsServerTestHelper::doocsSetMany(write);
+
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//LOC/INT"), -3);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//OTHER/INT"), 77);
+
+  // read them back in one batch
+  int intValue{0}, otherInt{0};
+  int64_t longValue{0};
+  double doubleValue{0};
+  std::string text;
+  std::vector<int> intArray;
+  std::vector<double> doubleArray;
+  DoocsServerTestHelper::ReadBatch read;
+  read.add("//LOC/INT", intValue);
+  read.add("//LOC/LONG", longValue);
+  read.add("//LOC/DOUBLE", doubleValue);
+  read.add("//LOC/TEXT", text);
+  read.add("//LOC/INT_ARRAY", intArray);
+  read.add("//OTHER/DOUBLE_ARRAY", doubleArray);
+  read.add("//OTHER/INT", otherInt);
+  DoocsServerTestHelper::doocsGetMany(read);
+
+  BOOST_CHECK_EQUAL(intValue, -3);
+  BOOST_CHECK_EQUAL(longValue, (1LL << 40) + 3);
+  BOOST_CHECK_EQUAL(doubleValue, 0.25);
+  BOOST_CHECK_EQUAL(text, "batch");
+  BOOST_CHECK((intArray == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+  BOOST_CHECK((doubleArray == std::vector<double>{0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5}));
+  BOOST_CHECK_EQUAL(otherInt, 77);
+
+  // batches can be used repeatedly and pick up changed values
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT", 11);
+  DoocsServerTestHelper::doocsSetMany(write);
+  DoocsServerTestHelper::doocsSet<int>("//OTHER/INT", 12);
+  DoocsServerTestHelper::doocsGetMany(read);
+  BOOST_CHECK_EQUAL(intValue, -3);
+  BOOST_CHECK_EQUAL(otherInt, 12);
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestSpectrum) {
+  server->reset();
+
+  // single precision, from a vector and from a span
+  DoocsServerTestHelper::doocsSetSpectrum("//LOC/SPECTRUM", {1.5F, -2.F, 3.25F});
+  BOOST_CHECK((DoocsServerTestHelper::doocsGetArray<float>("//LOC/SPECTRUM") == std::vector<float>{1.5F, -2.F, 3.25F}));
+  std::array<float, 4> data{4.F, 5.F, 6.F, 7.F};
+  DoocsServerTestHelper::doocsSetSpectrum("//LOC/SPECTRUM", std::span<const float>(data));
+  auto result = DoocsServerTestHelper::doocsGetArray<float>("//LOC/SPECTRUM");
+  BOOST_CHECK((result == std::vector<float>(data.begin(), data.end())));
+
+  // double precision input is rounded to float, values outside the float range become infinite
+  std::vector<double> doubles{0.1, -1e-3, 1e300, 123456789.};
+  DoocsServerTestHelper::doocsSetSpectrum("//LOC/SPECTRUM", std::span<const double>(doubles));
+  result = DoocsServerTestHelper::doocsGetArray<float>("//LOC/SPECTRUM");
+  BOOST_REQUIRE_EQUAL(result.size(), doubles.size());
+  BOOST_CHECK_EQUAL(result[0], 0.1F);
+  BOOST_CHECK_EQUAL(result[1], -1e-3F);
+  BOOST_CHECK(std::isinf(result[2]));
+  BOOST_CHECK_EQUAL(result[3], 123456789.F);
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestImage) {
+  server->reset();
+
+  IMH header{};
+  header.width = 4;
+  header.height = 2;
+  header.aoi_width = 4;
+  header.aoi_height = 2;
+  header.bpp = 1;
+  header.ebitpp = 8;
+  header.image_format = TTF2_IMAGE_FORMAT_GRAY;
+  std::vector<uint8_t> pixels{0, 1, 2, 3, 252, 253, 254, 255};
+  DoocsServerTestHelper::doocsSetImage("//LOC/IMAGE", header, pixels);
+
+  // read the image back directly, the helper has no getter for images
+  EqAdr adr;
+  adr.adr("//LOC/IMAGE");
+  EqFct* location = eq_get(&adr);
+  BOOST_REQUIRE(location != nullptr);
+  EqData res;
+  location->lock();
+  location->get(&adr, nullptr, &res);
+  location->unlock();
+  BOOST_REQUIRE_EQUAL(res.error(), 0);
+
+  IMH resultHeader{};
+  u_char* resultData{nullptr};
+  int resultLength{0};
+  BOOST_REQUIRE(res.get_image(&resultData, &resultLength, &resultHeader));
+  BOOST_CHECK_EQUAL(resultHeader.width, 4);
+  BOOST_CHECK_EQUAL(resultHeader.height, 2);
+  BOOST_CHECK_EQUAL(resultHeader.bpp, 1);
+  BOOST_CHECK_EQUAL(resultHeader.image_format, TTF2_IMAGE_FORMAT_GRAY);
+  // the length in the header is taken from the data
+  BOOST_CHECK_EQUAL(resultHeader.length, int(pixels.size()));
+  BOOST_REQUIRE_EQUAL(resultLength, int(pixels.size()));
+  BOOST_CHECK((std::vector<uint8_t>(resultData, resultData + resultLength) == pixels));
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestRunUpdateFor) {
+  server->reset();
+
+  auto updatesLoc = DoocsServerTestHelper::doocsGet<int>("//LOC/UPDATES");
+  auto updatesOther = DoocsServerTestHelper::doocsGet<int>("//OTHER/UPDATES");
+  auto nProcessed = DoocsServerTestHelper::getUpdateStatistics().processing.count();
+  int fd = DoocsServerTestHelper::getEventFd();
+  uint64_t events = 0;
+  [[maybe_unused]] auto drained = read(fd, &events, sizeof(events));
+
+  // each cycle advances the virtual clock before update() is called, which sees the virtual time
+  DoocsServerTestHelper::enableVirtualClock(std::chrono::seconds(10), std::chrono::system_clock::from_time_t(1000));
+  DoocsServerTestHelper::runUpdateFor({"LOC"}, 3);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//LOC/UPDATES"), updatesLoc + 3);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int64_t>("//LOC/LAST_UPDATE_TIME"), 1030);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == std::chrono::system_clock::from_time_t(1030));
+
+  // the other location is not updated
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//OTHER/UPDATES"), updatesOther);
+
+  // each cycle is recorded in the statistics and signalled as progress event
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::getUpdateStatistics().processing.count(), nProcessed + 3);
+  BOOST_CHECK_EQUAL(read(fd, &events, sizeof(events)), sizeof(events));
+  BOOST_CHECK_EQUAL(events, 3);
+
+  // the calling thread still sees the real time afterwards
+  BOOST_CHECK(std::chrono::system_clock::now() > std::chrono::system_clock::from_time_t(1000000000));
+
+  // a regular cycle of the update thread continues from the virtual time reached
+  DoocsServerTestHelper::runUpdate();
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int64_t>("//OTHER/LAST_UPDATE_TIME"), 1040);
+  DoocsServerTestHelper::disableVirtualClock();
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestWaitForValue) {
+  server->reset();
+  auto isEqual = [](int expected) { return [expected](int value) { return value == expected; }; };
+
+  // already fulfilled
+  BOOST_CHECK(DoocsServerTestHelper::waitForValue<int>("//LOC/INT", isEqual(42), std::chrono::milliseconds(0)));
+
+  // written through the helper from another thread, which wakes up the waiting thread
+  std::thread writer([] {
+    usleep(50000);
+    DoocsServerTestHelper::doocsSet<int>("//LOC/INT", 43);
+  });
+  BOOST_CHECK(DoocsServerTestHelper::waitForValue<int>("//LOC/INT", isEqual(43), std::chrono::seconds(5)));
+  writer.join();
+
+  // changed by the server on its own, which is found by polling
+  EqAdr adr;
+  adr.adr("//OTHER/INT");
+  auto* other = dynamic_cast<TestLocation*>(eq_get(&adr));
+  BOOST_REQUIRE(other != nullptr);
+  std::thread serverSide([&] {
+    usleep(50000);
+    other->lock();
+    other->intValue.set_value(44);
+    other->unlock();
+  });
+  BOOST_CHECK(DoocsServerTestHelper::waitForValue<int>(
+      "//OTHER/INT", isEqual(44), std::chrono::seconds(5), std::chrono::milliseconds(10)));
+  serverSide.join();
+
+  // not fulfilled within the timeout
+  auto start = std::chrono::steady_clock::now();
+  BOOST_CHECK(!DoocsServerTestHelper::waitForValue<int>("//LOC/INT", isEqual(0), std::chrono::milliseconds(200)));
+  auto duration = std::chrono::steady_clock::now() - start;
+  BOOST_CHECK(duration >= std::chrono::milliseconds(200));
+  BOOST_CHECK(duration < std::chrono::seconds(5));
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestScenario) {
+  server->reset();
+
+  // 64-bit integers are written and compared without loss, fractional values are not truncated
+  auto scenario = DoocsScenario::fromString(R"(
+    set //LOC/LONG 9007199254740993
+    set //LOC/INT -7
+    set //LOC/DOUBLE 2.5
+    step
+    expect //LOC/LONG 9007199254740993
+    expect //LOC/INT -7
+    expect //LOC/DOUBLE 2.5
+    expect //LOC/DOUBLE 2
+    expect //LOC/LONG 9007199254740992
+  )");
+  auto failures = scenario.run(true);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int64_t>("//LOC/LONG"), (int64_t(1) << 53) + 1);
+  BOOST_REQUIRE_EQUAL(failures.size(), 2);
+  BOOST_CHECK_EQUAL(failures[0].line, 9);
+  BOOST_CHECK_EQUAL(failures[0].message, "//LOC/DOUBLE: expected 2, got 2.5");
+  BOOST_CHECK_EQUAL(failures[1].line, 10);
+  BOOST_CHECK_EQUAL(failures[1].message, "//LOC/LONG: expected 9007199254740992, got 9007199254740993");
+}
+
+/**********************************************************************************************************************/
+
+// must be the last test case, since the saved state is used by all further calls to reset()
+BOOST_AUTO_TEST_CASE(TestResetToSavedState) {
+  server->reset();
+
+  // bring the server into the state to be saved, including properties without a value in the config file
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT", 5);
+  DoocsServerTestHelper::doocsSet<float>("//LOC/FLOAT", 3.5F);
+  DoocsServerTestHelper::doocsSet<std::string>("//LOC/TEXT", "saved");
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT_ARRAY", {9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
+  DoocsServerTestHelper::doocsSetSpectrum("//LOC/SPECTRUM", {1.F, 2.F});
+  DoocsServerTestHelper::doocsSet<int>("//OTHER/INT", 6);
+  server->saveState();
+
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT", 50);
+  DoocsServerTestHelper::doocsSet<float>("//LOC/FLOAT", -1.F);
+  DoocsServerTestHelper::doocsSet<std::string>("//LOC/TEXT", "changed");
+  DoocsServerTestHelper::doocsSet<int>("//LOC/INT_ARRAY", {0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  DoocsServerTestHelper::doocsSetSpectrum("//LOC/SPECTRUM", {3.F, 4.F, 5.F});
+  DoocsServerTestHelper::doocsSet<int>("//OTHER/INT", 60);
+
+  // the saved values are written back instead of the config values
+  server->reset();
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//LOC/INT"), 5);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<float>("//LOC/FLOAT"), 3.5F);
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<std::string>("//LOC/TEXT"), "saved");
+  BOOST_CHECK((DoocsServerTestHelper::doocsGetArray<int>("//LOC/INT_ARRAY") ==
+      std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0}));
+  BOOST_CHECK((DoocsServerTestHelper::doocsGetArray<float>("//LOC/SPECTRUM") == std::vector<float>{1.F, 2.F}));
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<int>("//OTHER/INT"), 6);
+
+  // unchanged values stay as they are
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::doocsGet<double>("//LOC/DOUBLE"), 1.5);
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
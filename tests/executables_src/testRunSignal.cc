@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+using namespace boost::unit_test_framework;
+
+// simulates a DOOCS signal thread waiting for more than just SIGUSR1
+std::thread threadSignals;
+std::mutex receivedMutex;
+std::vector<int> received;
+
+// number of signals received before the shutdown
+size_t nReceivedBeforeShutdown{0};
+
+// thread waiting only for other signals, which are not processed with doNotProcessSignalsInDoocs
+std::thread threadOtherSignals;
+std::atomic<bool> otherSignalReturned{false};
+std::atomic<int> otherSignal{0};
+
+void HelperTest::testRoutineBody() {
+  // without a signal thread waiting for SIGUSR1, the signal cannot be delivered
+  BOOST_CHECK_THROW(DoocsServerTestHelper::runSignal(SIGUSR2, std::chrono::milliseconds(100)), std::logic_error);
+
+  threadSignals = std::thread([] {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGUSR2);
+    sigaddset(&set, SIGHUP);
+    while(!flagTerminate) {
+      int sig;
+      DoocsServerTestHelper::sigwait(&set, &sig);
+      std::lock_guard<std::mutex> lock(receivedMutex);
+      received.push_back(sig);
+    }
+  });
+
+  // signals outside the set are rejected, also before the thread has entered sigwait() for the first time
+  BOOST_CHECK_THROW(DoocsServerTestHelper::runSignal(SIGTERM), std::logic_error);
+
+  // the signal is delivered and handled before runSignal() returns
+  DoocsServerTestHelper::runSignal(SIGUSR2);
+  {
+    std::lock_guard<std::mutex> lock(receivedMutex);
+    BOOST_CHECK((received == std::vector<int>{SIGUSR2}));
+  }
+  DoocsServerTestHelper::runSignal(SIGHUP);
+  DoocsServerTestHelper::runSigusr1();
+  DoocsServerTestHelper::runSignal(SIGUSR1);
+  {
+    std::lock_guard<std::mutex> lock(receivedMutex);
+    BOOST_CHECK((received == std::vector<int>{SIGUSR2, SIGHUP, SIGUSR1, SIGUSR1}));
+  }
+
+  // signals outside the set are rejected
+  BOOST_CHECK_THROW(DoocsServerTestHelper::runSignal(SIGTERM), std::logic_error);
+
+  // the last signal before the shutdown is not SIGUSR1
+  DoocsServerTestHelper::runSignal(SIGUSR2);
+  {
+    std::lock_guard<std::mutex> lock(receivedMutex);
+    BOOST_CHECK_EQUAL(received.back(), SIGUSR2);
+    nReceivedBeforeShutdown = received.size();
+  }
+
+  // with doNotProcessSignalsInDoocs, a thread waiting for other signals blocks after receiving a signal until the
+  // shutdown
+  DoocsServerTestHelper::setDoNotProcessSignalsInDoocs();
+  std::promise<void> waiting;
+  threadOtherSignals = std::thread([&] {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    waiting.set_value();
+    int sig;
+    DoocsServerTestHelper::sigwait(&set, &sig);
+    otherSignal = sig;
+    otherSignalReturned = true;
+  });
+  waiting.get_future().wait();
+  pthread_kill(threadOtherSignals.native_handle(), SIGUSR2);
+  usleep(100000);
+  BOOST_CHECK(otherSignalReturned == false);
+}
+
+BOOST_AUTO_TEST_CASE(TestRunSignal) {
+  HelperTest test;
+  test.testRoutine();
+
+  // both threads have been released by the shutdown
+  threadSignals.join();
+  threadOtherSignals.join();
+  BOOST_CHECK(otherSignalReturned == true);
+
+  // the suppressed signal is not passed on to DOOCS after the release
+  BOOST_CHECK_EQUAL(otherSignal, SIGUSR1);
+
+  // after the shutdown, sigwait() returns SIGUSR1 only, not the signal of the last batch
+  for(size_t i = nReceivedBeforeShutdown; i < received.size(); ++i) {
+    BOOST_CHECK_EQUAL(received[i], SIGUSR1);
+  }
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  sigaddset(&set, SIGUSR2);
+  for(size_t i = 0; i < 3; ++i) {
+    int sig = 0;
+    DoocsServerTestHelper::sigwait(&set, &sig);
+    BOOST_CHECK_EQUAL(sig, SIGUSR1);
+  }
+}
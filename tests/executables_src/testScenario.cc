@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+#include "DoocsScenario.h"
+#include "testDoocsServerTestHelper_access.h"
+
+#include <limits>
+
+using namespace boost::unit_test_framework;
+
+// gives access to the parsed commands and the comparison, so it can be checked without DOOCS properties
+struct ScenarioAccess : DoocsScenario {
+  explicit ScenarioAccess(DoocsScenario&& scenario) : DoocsScenario(std::move(scenario)) {}
+  using DoocsScenario::_commands;
+  using DoocsScenario::compare;
+};
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // parse a script with all commands
+  auto scenario = DoocsScenario::fromString(R"(
+    # comment line
+    set //LOC/INT 42
+    set //LOC/FLOAT 1.5   # trailing comment
+    set //LOC/TEXT "some text"
+    step
+    step 3
+    sigusr1 2
+    expect //LOC/FLOAT 1.5 +- 0.01
+    expect //LOC/TEXT "some text"
+    waitfor //LOC/INT 43 within 10
+  )");
+  BOOST_CHECK_EQUAL(scenario.size(), 9);
+
+  // syntax errors are reported with the line number
+  auto checkSyntaxError = [](const std::string& script, const std::string& expectedMessage) {
+    try {
+      DoocsScenario::fromString(script, "test.scenario");
+      BOOST_ERROR("No exception thrown for: " + script);
+    }
+    catch(std::runtime_error& e) {
+      BOOST_CHECK_MESSAGE(std::string(e.what()).find(expectedMessage) != std::string::npos, e.what());
+    }
+  };
+  checkSyntaxError("step\nfoo", "test.scenario:2: unknown command 'foo'");
+  checkSyntaxError("step x", "test.scenario:1: invalid number of cycles 'x'");
+  checkSyntaxError("set //LOC/INT", "needs a property and a value");
+  checkSyntaxError("expect //LOC/TEXT abc +- 1", "tolerance requires numeric values");
+  checkSyntaxError("expect //LOC/INT 1 within 3", "unexpected argument 'within'");
+  checkSyntaxError("set //LOC/TEXT \"abc", "unterminated quote");
+
+  // numeric values are compared with the tolerance
+  ScenarioAccess compared(DoocsScenario::fromString(R"(
+    expect //LOC/DBL 0.1
+    expect //LOC/INT 16777217
+    expect //LOC/FLOAT 1.5 +- 0.01
+    waitfor //LOC/TEXT "some text"
+  )"));
+  BOOST_REQUIRE_EQUAL(compared._commands.size(), 4);
+  BOOST_CHECK(!ScenarioAccess::compare(compared._commands[0], 0.1));
+  BOOST_CHECK(ScenarioAccess::compare(compared._commands[0], static_cast<double>(0.1F)));
+  BOOST_CHECK(!ScenarioAccess::compare(compared._commands[1], 16777217.));
+  BOOST_CHECK(ScenarioAccess::compare(compared._commands[1], 16777216.));
+  BOOST_CHECK(!ScenarioAccess::compare(compared._commands[2], 1.509));
+  BOOST_CHECK(!ScenarioAccess::compare(compared._commands[2], 1.491));
+  auto error = ScenarioAccess::compare(compared._commands[2], 1.52);
+  BOOST_REQUIRE(error);
+  BOOST_CHECK_EQUAL(*error, "//LOC/FLOAT: expected 1.5 +- 0.01, got 1.52");
+  BOOST_CHECK(!ScenarioAccess::compare(compared._commands[3], std::string("some text")));
+  error = ScenarioAccess::compare(compared._commands[3], std::string("other text"));
+  BOOST_REQUIRE(error);
+  BOOST_CHECK_EQUAL(*error, "//LOC/TEXT: expected \"some text\", got \"other text\"");
+
+  // integers are compared exactly, also beyond the precision of a double
+  ScenarioAccess integers(DoocsScenario::fromString(R"(
+    expect //LOC/LONG 9007199254740993
+    expect //LOC/LONG -9223372036854775808 +- 2
+    expect //LOC/LONG 1.0
+  )"));
+  BOOST_REQUIRE_EQUAL(integers._commands.size(), 3);
+  BOOST_CHECK(integers._commands[0].integerValue == (int64_t(1) << 53) + 1);
+  BOOST_CHECK(!ScenarioAccess::compare(integers._commands[0], (int64_t(1) << 53) + 1));
+  error = ScenarioAccess::compare(integers._commands[0], int64_t(1) << 53);
+  BOOST_REQUIRE(error);
+  BOOST_CHECK_EQUAL(*error, "//LOC/LONG: expected 9007199254740993, got 9007199254740992");
+  BOOST_CHECK(!ScenarioAccess::compare(integers._commands[1], std::numeric_limits<int64_t>::min() + 2));
+  BOOST_CHECK(ScenarioAccess::compare(integers._commands[1], std::numeric_limits<int64_t>::max()));
+  BOOST_CHECK(!integers._commands[2].integerValue);
+
+  // values are read without loss of precision
+  EqData data;
+  data.set(0.1);
+  BOOST_CHECK_EQUAL(HelperAccess::fromEqData<double>(data), 0.1);
+  data.set(16777217);
+  BOOST_CHECK_EQUAL(HelperAccess::fromEqData<double>(data), 16777217.);
+  data.set(static_cast<long long>((1LL << 40) + 1));
+  BOOST_CHECK_EQUAL(HelperAccess::fromEqData<int64_t>(data), (1LL << 40) + 1);
+
+  // run a scenario with update and sigusr1 cycles
+  auto cycles = DoocsScenario::fromString("step 2\nsigusr1\n");
+  std::thread t1([&] {
+    usleep(100000);
+    allowUpdate();
+    allowUpdate();
+    allowSigusr1();
+  });
+  auto failures = cycles.run();
+  BOOST_CHECK(failures.empty());
+  t1.join();
+  waitUpdate();
+  waitUpdate();
+  waitSigusr1();
+}
+
+BOOST_AUTO_TEST_CASE(TestScenario) {
+  HelperTest test;
+  test.testRoutine();
+}
@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_access.h"
+
+#include <boost/test/included/unit_test.hpp>
+
+using namespace boost::unit_test_framework;
+
+// serialise a single value
+static std::string serialise(EqData& value) {
+  std::string buffer;
+  SnapshotAccess::serialise(value, buffer);
+  return buffer;
+}
+
+BOOST_AUTO_TEST_CASE(TestSerialise) {
+  // equal values give the same bytes
+  EqData a, b;
+  a.set(42);
+  b.set(42);
+  BOOST_CHECK(serialise(a) == serialise(b));
+  b.set(43);
+  BOOST_CHECK(serialise(a) != serialise(b));
+
+  // the type is part of the value
+  b.set(42.);
+  BOOST_CHECK(serialise(a) != serialise(b));
+
+  // strings
+  a.set(std::string("some text"));
+  b.set(std::string("some text"));
+  BOOST_CHECK(serialise(a) == serialise(b));
+  b.set(std::string("other text"));
+  BOOST_CHECK(serialise(a) != serialise(b));
+
+  // arrays, including the length
+  EqData c, d;
+  HelperAccess::toEqData(std::vector<int>{1, 2, 3}, c);
+  HelperAccess::toEqData(std::vector<int>{1, 2, 3}, d);
+  BOOST_CHECK(serialise(c) == serialise(d));
+  HelperAccess::toEqData(std::vector<int>{1, 2, 4}, d);
+  BOOST_CHECK(serialise(c) != serialise(d));
+  EqData e;
+  HelperAccess::toEqData(std::vector<int>{1, 2, 3, 0}, e);
+  BOOST_CHECK(serialise(c) != serialise(e));
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestDiff) {
+  auto layout = SnapshotAccess::makeLayout({"//LOC/INT", "//LOC/FLOAT", "//LOC/TEXT", "//LOC/ARRAY"});
+  EqData i1, f1, t1, a1;
+  i1.set(1);
+  f1.set(1.5F);
+  t1.set(std::string("x"));
+  HelperAccess::toEqData(std::vector<double>{1., 2.}, a1);
+  SnapshotAccess first(layout, {&i1, &f1, &t1, &a1});
+  BOOST_CHECK_EQUAL(first.size(), size_t(4));
+
+  // a snapshot without changes has no diff
+  EqData i2, f2, t2, a2;
+  i2.set(1);
+  f2.set(1.5F);
+  t2.set(std::string("x"));
+  HelperAccess::toEqData(std::vector<double>{1., 2.}, a2);
+  SnapshotAccess same(layout, {&i2, &f2, &t2, &a2});
+  BOOST_CHECK(first.diff(same).empty());
+  BOOST_CHECK(first.diff(first).empty());
+
+  // exactly the changed properties are reported, in the order of the layout
+  f2.set(2.5F);
+  HelperAccess::toEqData(std::vector<double>{1., 3.}, a2);
+  SnapshotAccess changed(layout, {&i2, &f2, &t2, &a2});
+  BOOST_CHECK((first.diff(changed) == std::vector<std::string>{"//LOC/FLOAT", "//LOC/ARRAY"}));
+  BOOST_CHECK((changed.diff(first) == std::vector<std::string>{"//LOC/FLOAT", "//LOC/ARRAY"}));
+}
+
+/**********************************************************************************************************************/
+
+BOOST_AUTO_TEST_CASE(TestSharedLayout) {
+  EqData value;
+  value.set(1);
+
+  // snapshots taken from each other share the list of properties
+  auto layout = SnapshotAccess::makeLayout({"//LOC/INT"});
+  SnapshotAccess first(layout, {&value});
+  SnapshotAccess second(layout, {&value});
+  BOOST_CHECK(&first.getNames() == &second.getNames());
+  BOOST_CHECK_EQUAL(layout.use_count(), 3);
+
+  // separate layouts with the same properties can still be compared
+  SnapshotAccess separate(SnapshotAccess::makeLayout({"//LOC/INT"}), {&value});
+  BOOST_CHECK(&first.getNames() != &separate.getNames());
+  BOOST_CHECK(first.diff(separate).empty());
+
+  // snapshots of different properties cannot be compared
+  SnapshotAccess other(SnapshotAccess::makeLayout({"//LOC/OTHER"}), {&value});
+  BOOST_CHECK_THROW(first.diff(other), std::logic_error);
+}
+
+/**********************************************************************************************************************/
+
+// necessary exported symbols to satisfy the DOOCS server lib
+const char* object_name = "";
+inline void interrupt_usr1_prolog(int) {}
+inline void post_init_epilog() {}
+inline void refresh_epilog() {}
+inline void refresh_prolog() {}
+inline void eq_init_epilog() {}
+inline void eq_init_prolog() {}
+inline void eq_cancel() {}
+inline void post_init_prolog() {}
+inline void eqCreate(int, void*) {}
+inline void interrupt_usr1_epilog(int) {}
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+#include <sstream>
+
+using namespace boost::unit_test_framework;
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // histogram: percentiles are rounded up to the bucket boundary (resolution better than 25%)
+  DoocsServerTestHelper::LatencyHistogram histogram;
+  BOOST_CHECK_EQUAL(histogram.count(), 0);
+  BOOST_CHECK(histogram.percentile(0.5) == std::chrono::nanoseconds(0));
+  for(int i = 1; i <= 100; ++i) {
+    histogram.record(std::chrono::microseconds(i));
+  }
+  BOOST_CHECK_EQUAL(histogram.count(), 100);
+  auto p50 = histogram.percentile(0.5);
+  BOOST_CHECK(p50 >= std::chrono::microseconds(50));
+  BOOST_CHECK(p50 <= std::chrono::microseconds(63));
+  BOOST_CHECK(histogram.percentile(1.) >= std::chrono::microseconds(100));
+  histogram.reset();
+  BOOST_CHECK_EQUAL(histogram.count(), 0);
+
+  // timing statistics are recorded for each cycle of a batch, the completion once per batch
+  std::thread t1([&] {
+    for(size_t i = 0; i < 3; ++i) {
+      usleep(100000);
+      allowUpdate();
+    }
+  });
+  DoocsServerTestHelper::runUpdate(3);
+  t1.join();
+  for(size_t i = 0; i < 3; ++i) {
+    waitUpdate();
+  }
+  const auto& statistics = DoocsServerTestHelper::getUpdateStatistics();
+  BOOST_CHECK_EQUAL(statistics.wakeup.count(), 3);
+  BOOST_CHECK_EQUAL(statistics.processing.count(), 3);
+  BOOST_CHECK_EQUAL(statistics.completion.count(), 1);
+  BOOST_CHECK(statistics.processing.percentile(0.5) >= std::chrono::milliseconds(50));
+  BOOST_CHECK_EQUAL(DoocsServerTestHelper::getSigusr1Statistics().processing.count(), 0);
+
+  std::stringstream summary;
+  DoocsServerTestHelper::printStatistics(summary);
+  BOOST_CHECK(summary.str().find("processing") != std::string::npos);
+
+  DoocsServerTestHelper::resetStatistics();
+  BOOST_CHECK_EQUAL(statistics.processing.count(), 0);
+
+  // reset() clears the statistics and restores the default retry policy
+  std::thread t2([&] {
+    usleep(100000);
+    allowUpdate();
+  });
+  DoocsServerTestHelper::runUpdate();
+  t2.join();
+  waitUpdate();
+  BOOST_CHECK_EQUAL(statistics.processing.count(), 1);
+  DoocsServerTestHelper::RetryPolicy policy;
+  policy.failFast = true;
+  DoocsServerTestHelper::setRetryPolicy(policy);
+  DoocsServerTestHelper::reset();
+  BOOST_CHECK_EQUAL(statistics.processing.count(), 0);
+  BOOST_CHECK(DoocsServerTestHelper::getRetryPolicy().failFast == false);
+}
+
+BOOST_AUTO_TEST_CASE(TestStatistics) {
+  HelperTest test;
+  test.testRoutine();
+}
@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+#include <sys/time.h>
+
+using namespace boost::unit_test_framework;
+
+// gives access to the real-time sleep used by the helper itself
+struct VirtualClockTest : public DoocsServerTestHelper {
+  using DoocsServerTestHelper::realSleep;
+};
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // threads other than the server threads keep seeing the real time, the virtual time can be read explicitly
+  DoocsServerTestHelper::enableVirtualClock(std::chrono::seconds(0), std::chrono::system_clock::from_time_t(1000));
+  BOOST_CHECK(time(nullptr) > 1000);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == std::chrono::system_clock::from_time_t(1000));
+  DoocsServerTestHelper::advanceVirtualClock(std::chrono::milliseconds(1500));
+  auto tVirtual = std::chrono::system_clock::from_time_t(1001) + std::chrono::milliseconds(500);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == tVirtual);
+
+  // sleeps outside the server threads are not affected, also absolute ones on the wall clock
+  auto t0 = std::chrono::steady_clock::now();
+  usleep(10000);
+  BOOST_CHECK(std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(10));
+  t0 = std::chrono::steady_clock::now();
+  struct timespec deadline {};
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += 10000000;
+  if(deadline.tv_nsec >= 1000000000) {
+    deadline.tv_nsec -= 1000000000;
+    ++deadline.tv_sec;
+  }
+  BOOST_CHECK_EQUAL(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &deadline, nullptr), 0);
+  auto slept = std::chrono::steady_clock::now() - t0;
+  BOOST_CHECK(slept >= std::chrono::milliseconds(9));
+  BOOST_CHECK(slept < std::chrono::seconds(5));
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == tVirtual);
+
+  // use a second server to simulate an update thread which sleeps inside update()
+  doocs::Server server("secondServer");
+  DoocsServerTestHelper::initialise(&server);
+  auto& second = DoocsServerTestHelper::getInstance(&server);
+  std::atomic<size_t> nSleeps{0};
+  std::atomic<bool> sleepInUpdate{false};
+  std::atomic<bool> terminate{false};
+  std::thread threadSecondUpdate([&] {
+    while(!terminate) {
+      DoocsServerTestHelper::waitForUpdate(&server);
+      if(terminate) {
+        break;
+      }
+      if(sleepInUpdate) {
+        sleep(10);
+        ++nSleeps;
+      }
+    }
+  });
+
+  // the server threads see the virtual time through all clock functions
+  time_t tTime{};
+  struct timeval tv {};
+  std::chrono::system_clock::time_point tChrono;
+  second.runUpdate(1, [&](size_t) {
+    tTime = time(nullptr);
+    gettimeofday(&tv, nullptr);
+    tChrono = std::chrono::system_clock::now();
+  });
+  BOOST_CHECK_EQUAL(tTime, 1001);
+  BOOST_CHECK_EQUAL(tv.tv_sec, 1001);
+  BOOST_CHECK_EQUAL(tv.tv_usec, 500000);
+  BOOST_CHECK(tChrono == tVirtual);
+
+  // the sleep only returns once the virtual time has been advanced past the wakeup time
+  sleepInUpdate = true;
+  auto f1 = second.runUpdateAsync();
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  DoocsServerTestHelper::advanceVirtualClock(std::chrono::seconds(9));
+  BOOST_CHECK(f1.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+  BOOST_CHECK_EQUAL(nSleeps, 0);
+  DoocsServerTestHelper::advanceVirtualClock(std::chrono::seconds(1));
+  BOOST_CHECK(f1.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(nSleeps, 1);
+
+  // each update cycle can advance the virtual clock automatically
+  sleepInUpdate = false;
+  DoocsServerTestHelper::enableVirtualClock(std::chrono::seconds(10), std::chrono::system_clock::from_time_t(2000));
+  second.runUpdate(3);
+  BOOST_CHECK(DoocsServerTestHelper::getVirtualClockTime() == std::chrono::system_clock::from_time_t(2030));
+
+  // the helper's own waits (e.g. between retries of property accesses) are done in real time, also in server threads
+  // where the test thread cannot advance the virtual clock (here: in a cycle callback)
+  slept = {};
+  second.runUpdate(1, [&](size_t) {
+    auto tSleep = std::chrono::steady_clock::now();
+    VirtualClockTest::realSleep(std::chrono::milliseconds(10));
+    slept = std::chrono::steady_clock::now() - tSleep;
+  });
+  BOOST_CHECK(slept >= std::chrono::milliseconds(10));
+
+  // disabling returns to the real time
+  DoocsServerTestHelper::disableVirtualClock();
+  second.runUpdate(1, [&](size_t) { tTime = time(nullptr); });
+  BOOST_CHECK(tTime > 2040);
+
+  // reset() disables the virtual clock as well
+  DoocsServerTestHelper::enableVirtualClock(std::chrono::seconds(0), std::chrono::system_clock::from_time_t(3000));
+  second.runUpdate(1, [&](size_t) { tTime = time(nullptr); });
+  BOOST_CHECK_EQUAL(tTime, 3000);
+  DoocsServerTestHelper::reset();
+  BOOST_CHECK(!DoocsServerTestHelper::getVirtualClockEnabled());
+  second.runUpdate(1, [&](size_t) { tTime = time(nullptr); });
+  BOOST_CHECK(tTime > 3000);
+
+  terminate = true;
+  second.release();
+  threadSecondUpdate.join();
+}
+
+BOOST_AUTO_TEST_CASE(TestVirtualClock) {
+  HelperTest test;
+  test.testRoutine();
+}
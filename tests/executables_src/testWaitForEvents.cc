@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE testApplication
+
+#include "testDoocsServerTestHelper_skeleton.h"
+
+#include <poll.h>
+
+using namespace boost::unit_test_framework;
+
+void HelperTest::testRoutineBody() {
+  // allow the update thread to enter nanosleep and the sigusr1 thread to enter
+  // sigwait
+  allowUpdate();
+  allowSigusr1();
+
+  // without any event, waiting on a subscription times out
+  auto subscription = DoocsServerTestHelper::subscribe();
+  BOOST_CHECK(!subscription.waitFor(std::chrono::milliseconds(100)));
+
+  // a completed update cycle wakes up the subscription
+  std::atomic<bool> woken{false};
+  std::thread t1([&] {
+    woken = subscription.waitFor(std::chrono::seconds(5));
+  });
+  usleep(100000);
+  BOOST_CHECK(woken == false);
+  std::thread t2([&] {
+    usleep(100000);
+    allowUpdate();
+  });
+  DoocsServerTestHelper::runUpdate();
+  t1.join();
+  t2.join();
+  waitUpdate();
+  BOOST_CHECK(woken == true);
+
+  // the event has been consumed
+  BOOST_CHECK(!subscription.waitFor(std::chrono::milliseconds(10)));
+
+  // a completed sigusr1 cycle is observed as well, even if it happened before waiting
+  std::thread t3([&] {
+    usleep(100000);
+    allowSigusr1();
+  });
+  DoocsServerTestHelper::runSigusr1();
+  t3.join();
+  waitSigusr1();
+  BOOST_CHECK(subscription.waitFor(std::chrono::milliseconds(0)));
+
+  // the event file descriptor becomes readable when a cycle completes
+  int fd = DoocsServerTestHelper::getEventFd();
+  BOOST_CHECK_EQUAL(fd, DoocsServerTestHelper::getEventFd());
+  pollfd pfd{fd, POLLIN, 0};
+  BOOST_CHECK_EQUAL(poll(&pfd, 1, 0), 0);
+  std::thread t4([&] {
+    usleep(100000);
+    allowUpdate();
+    waitUpdate();
+    allowUpdate();
+  });
+  DoocsServerTestHelper::runUpdate(2);
+  t4.join();
+  waitUpdate();
+  BOOST_CHECK_EQUAL(poll(&pfd, 1, 0), 1);
+  uint64_t events = 0;
+  BOOST_CHECK_EQUAL(read(fd, &events, sizeof(events)), sizeof(events));
+  BOOST_CHECK_EQUAL(events, 2);
+  BOOST_CHECK_EQUAL(poll(&pfd, 1, 0), 0);
+
+  // the completion of an asynchronous batch is an event of its own, after the future has become ready
+  std::thread t5([&] {
+    usleep(100000);
+    allowUpdate();
+    waitUpdate();
+    allowUpdate();
+  });
+  auto batch = DoocsServerTestHelper::runUpdateAsync(2);
+  uint64_t total = 0;
+  while(batch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    BOOST_REQUIRE_EQUAL(poll(&pfd, 1, 5000), 1);
+    BOOST_CHECK_EQUAL(read(fd, &events, sizeof(events)), sizeof(events));
+    total += events;
+  }
+  if(total < 3) {
+    BOOST_REQUIRE_EQUAL(poll(&pfd, 1, 5000), 1);
+    BOOST_CHECK_EQUAL(read(fd, &events, sizeof(events)), sizeof(events));
+    total += events;
+  }
+  BOOST_CHECK_EQUAL(total, 3);
+  BOOST_CHECK_EQUAL(poll(&pfd, 1, 0), 0);
+  t5.join();
+  waitUpdate();
+}
+
+BOOST_AUTO_TEST_CASE(TestWaitForEvents) {
+  HelperTest test;
+  test.testRoutine();
+}